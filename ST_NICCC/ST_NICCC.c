@@ -6,13 +6,76 @@
 #include "io.h"
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+/*
+ * Time budget for decoding and drawing a frame. In streams with levels
+ * of detail, a coarser level is used when drawing takes more than
+ * LOD_SLOWER of the budget, and a finer one when it takes less than
+ * LOD_FASTER of the budget. gfx_swapbuffers() waits FRAME_TIME to pace
+ * the animation, the rest of the elapsed time of a frame (including the
+ * time blocked in gfx_swapbuffers() beyond that) is used for drawing.
+ */
+#define FRAME_TIME 0.02
+#define LOD_SLOWER 0.8
+#define LOD_FASTER 0.4
 
 ST_NICCC_IO io;
 ST_NICCC_FRAME frame;
 ST_NICCC_POLYGON polygon;
 
+/*
+ * Vertex table of the previous frame, interpolated with the one of
+ * motion frames.
+ */
+uint8_t prev_X[256];
+uint8_t prev_Y[256];
+
+/*
+ * Elapsed time in seconds, from a monotonic clock
+ */
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+void clear_screen() {
+    gfx_clear();
+    // The screen is cleared with the color of palette entry 0
+    if(
+        !gfx_wireframe &&
+        (frame.cmap_r[0] | frame.cmap_g[0] | frame.cmap_b[0])
+    ) {
+        int screen[8] = { 0,0, 255,0, 255,255, 0,255 };
+        gfx_setcolor(frame.cmap_r[0], frame.cmap_g[0], frame.cmap_b[0]);
+        gfx_fillpoly(4, screen);
+    }
+}
+
+void draw_polygons() {
+    while(st_niccc_read_polygon(&io,&frame,&polygon)) {
+        uint8_t color = polygon.color;
+        gfx_setcolor(
+            gfx_wireframe ? 255 : frame.cmap_r[color],
+            gfx_wireframe ? 255 : frame.cmap_g[color],
+            gfx_wireframe ? 255 : frame.cmap_b[color]
+        );
+        gfx_fillpoly(
+            polygon.nb_vertices,
+            polygon.XY
+        );
+    }
+}
+
+/*
+ * Usage: ST_NICCC [scene_file] [-wireframe] [-interp N]
+ *  -interp N: displays N frames per frame of the stream, motion frames
+ *   are interpolated.
+ */
 int main(int argc, char** argv) {
     const char* scene_file = "scene1.bin";
+    int nb_steps = 1;
     if(argc >= 2) {
         scene_file = argv[1];
     }
@@ -21,28 +84,77 @@ int main(int argc, char** argv) {
         exit(-1);
     }
     gfx_init();
-    if(argc >= 3) {
-        gfx_wireframe=!strcmp(argv[2],"-wireframe");
+    for(int i=2; i<argc; ++i) {
+        if(!strcmp(argv[i],"-wireframe")) {
+            gfx_wireframe = 1;
+        } else if(!strcmp(argv[i],"-interp") && i+1 < argc) {
+            nb_steps = atoi(argv[++i]);
+            if(nb_steps < 1) {
+                nb_steps = 1;
+            }
+        }
     }
     for(;;) {
         st_niccc_rewind(&io);
+        // Address of the polygons of the keyframe, 0 if there is none
+        uint32_t key_addr = 0;
+	double start = now();
 	while(st_niccc_read_frame(&io,&frame)) {
-            if(gfx_wireframe || frame.flags & CLEAR_BIT) {
-                gfx_clear();
+            if(frame.flags & MOTION_BIT) {
+                // Polygons of the keyframe, drawn with the new vertex table
+                uint8_t X[256];
+                uint8_t Y[256];
+                memcpy(X, frame.X, frame.nb_vertices);
+                memcpy(Y, frame.Y, frame.nb_vertices);
+                draw_polygons(); // skips END_OF_FRAME
+                uint32_t end_addr = io.addr;
+                for(int step=1; step<=nb_steps; ++step) {
+                    for(int v=0; v<frame.nb_vertices; ++v) {
+                        frame.X[v] = (uint8_t)(
+                            prev_X[v] + (X[v]-prev_X[v])*step/nb_steps
+                        );
+                        frame.Y[v] = (uint8_t)(
+                            prev_Y[v] + (Y[v]-prev_Y[v])*step/nb_steps
+                        );
+                    }
+                    if(key_addr != 0) {
+                        clear_screen();
+                        io.addr = key_addr;
+                        draw_polygons();
+                    }
+                    gfx_swapbuffers();
+                }
+                io.addr = end_addr;
+            } else {
+                if(frame.flags & HOLD_BIT) {
+                    // Same image as the previous frame
+                } else {
+                    if(gfx_wireframe || frame.flags & CLEAR_BIT) {
+                        clear_screen();
+                    }
+                    key_addr = io.addr;
+                }
+                draw_polygons();
+                for(int step=0; step<nb_steps; ++step) {
+                    gfx_swapbuffers();
+                }
             }
-            while(st_niccc_read_polygon(&io,&frame,&polygon)) {
-                uint8_t color = polygon.color;
-                gfx_setcolor(
-                    gfx_wireframe ? 255 : frame.cmap_r[color],
-                    gfx_wireframe ? 255 : frame.cmap_g[color],
-                    gfx_wireframe ? 255 : frame.cmap_b[color]
-                );
-                gfx_fillpoly(
-                    polygon.nb_vertices,
-                    polygon.XY
-                );
+            memcpy(prev_X, frame.X, sizeof(prev_X));
+            memcpy(prev_Y, frame.Y, sizeof(prev_Y));
+            if(frame.nb_levels > 1) {
+                double t = now() - start - FRAME_TIME * nb_steps;
+                if(
+                    t > LOD_SLOWER * FRAME_TIME * nb_steps &&
+                    frame.level+1 < frame.nb_levels
+                ) {
+                    io.lod = frame.level + 1;
+                } else if(
+                    t < LOD_FASTER * FRAME_TIME * nb_steps && frame.level > 0
+                ) {
+                    io.lod = frame.level - 1;
+                }
             }
-            gfx_swapbuffers();
+            start = now();
 	}
         gfx_wireframe = !gfx_wireframe;
     }
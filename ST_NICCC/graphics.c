@@ -150,6 +150,53 @@ void gfx_setcolor(int r, int g, int b) {
 
 /************************************************************/
 
+#ifdef GFX_BACKEND_MEMORY
+
+unsigned char gfx_framebuffer[GFX_SIZE*GFX_SIZE*3];
+unsigned char gfx_rgb_[3];
+
+static inline void gfx_setpixel_internal(int x, int y) {
+    assert(x >= 0 && x < GFX_SIZE);
+    assert(y >= 0 && y < GFX_SIZE);    
+    memcpy(gfx_framebuffer + 3*(y*GFX_SIZE+x), gfx_rgb_, 3);
+}
+
+static inline void gfx_hline_internal(int x1, int x2, int y) {
+    assert(x1 >= 0 && x1 < GFX_SIZE);
+    assert(x2 >= 0 && x2 < GFX_SIZE);    
+    assert(y >= 0 && y < GFX_SIZE);
+    if(x2 < x1) {
+        int tmp = x1;
+        x1 = x2;
+        x2 = tmp;
+    }
+    for(int x=x1; x<x2; ++x) {
+        gfx_setpixel_internal(x,y);
+    }
+}
+
+void gfx_init() {
+    gfx_wireframe = 0;
+    gfx_clear();
+}
+
+void gfx_swapbuffers() {
+}
+
+void gfx_clear() {
+    memset(gfx_framebuffer, 0, sizeof(gfx_framebuffer));
+}
+
+void gfx_setcolor(int r, int g, int b) {
+    gfx_rgb_[0] = (unsigned char)r;
+    gfx_rgb_[1] = (unsigned char)g;
+    gfx_rgb_[2] = (unsigned char)b;
+}
+
+#endif
+
+/************************************************************/
+
 void gfx_line(int x1, int y1, int x2, int y2) {
     int x,y,dx,dy,sy,tmp;
 
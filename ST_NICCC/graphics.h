@@ -6,6 +6,12 @@
 /* Uncomment one of them or define on command line */
 // #define GFX_BACKEND_ANSI
 // #define GFX_BACKEND_GLFW
+// #define GFX_BACKEND_MEMORY
+
+#ifdef GFX_BACKEND_MEMORY
+/* RGB pixels, row by row, drawn by gfx_fillpoly(), not displayed */
+extern unsigned char gfx_framebuffer[256*256*3];
+#endif
 
 extern int gfx_wireframe;
 
@@ -13,19 +13,34 @@ int st_niccc_open(
         return 0;
     }
     io->mode = mode;
+    io->lod = 0;
     st_niccc_rewind(io);
     return 1;
 }
 
+void st_niccc_open_counter(ST_NICCC_IO* io){
+    io->f = NULL;
+    io->mode = ST_NICCC_WRITE;
+    io->addr = 0;
+    io->word_addr = (uint32_t)(-1);
+    io->eof = 0;
+    io->lod = 0;
+    io->lod_end = 0;
+}
+
 void st_niccc_close(ST_NICCC_IO* io){
-    fclose(io->f);
+    if(io->f != NULL) {
+        fclose(io->f);
+    }
     io->f = NULL;
 }
 
 void st_niccc_rewind(ST_NICCC_IO* io){
     io->addr = 0;
     io->word_addr = (uint32_t)(-1);
+    io->nb_read = 0;
     io->eof = 0;
+    io->lod_end = 0;
     fseek(io->f, 0, SEEK_SET);
 }
 
@@ -34,19 +49,12 @@ uint8_t st_niccc_read_byte(ST_NICCC_IO* io){
    if(io->word_addr != io->addr >> 2) {
        io->word_addr = io->addr >> 2;
        fseek(io->f, io->word_addr*4, SEEK_SET);
-       size_t nb_read = fread(&(io->u.word), 4, 1, io->f);
-       if(nb_read != 1) {
-           // TODO:
-           // Seems that sometimes I got an error, this
-           // appeared when I started to merge triangles
-           // into polygons (for now, ignored, so that
-           // player can loop)
-           //
-           // fprintf(stderr,"ST_NICCC: read error\n");
-           // abort();
-           // exit(-1);
-           return END_OF_STREAM;
-       }
+       // The last word of the file can be incomplete
+       io->u.word = 0;
+       io->nb_read = fread(&(io->u.word), 1, 4, io->f);
+   }
+   if((io->addr & 3) >= io->nb_read) {
+       return END_OF_STREAM;
    }
    result = io->u.bytes[(io->addr)&3];
    ++(io->addr);
@@ -64,7 +72,9 @@ uint16_t st_niccc_read_word(ST_NICCC_IO* io){
 }
 
 void st_niccc_write_byte(ST_NICCC_IO* io, uint8_t b) {
-    fwrite(&b, 1, 1, io->f);
+    if(io->f != NULL) {
+        fwrite(&b, 1, 1, io->f);
+    }
     ++(io->addr);
 }
 
@@ -95,6 +105,38 @@ int st_niccc_read_frame(
         return 0;
     }
     frame->flags = st_niccc_read_byte(io);
+    frame->nb_levels = 1;
+    frame->level = 0;
+    frame->level_size = 0;
+
+    // Level of detail group: jump to the selected level
+    if(frame->flags & LOD_BIT) {
+        uint8_t nb_levels = st_niccc_read_byte(io);
+        uint8_t level = nb_levels - 1;
+        if(io->lod >= 0 && io->lod < nb_levels) {
+            level = (uint8_t)io->lod;
+        }
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        uint16_t selected_size = 0;
+        for(int l=0; l<nb_levels; ++l) {
+            uint16_t level_size = st_niccc_read_word(io);
+            if(l < level) {
+                offset += level_size;
+            }
+            if(l == level) {
+                selected_size = level_size;
+            }
+            size += level_size;
+        }
+        io->lod_end = io->addr + size;
+        io->addr += offset;
+        int result = st_niccc_read_frame(io, frame);
+        frame->nb_levels = nb_levels;
+        frame->level = level;
+        frame->level_size = selected_size;
+        return result;
+    }
 
     // Load palette data
     if(frame->flags & PALETTE_BIT) {
@@ -129,6 +171,11 @@ int st_niccc_read_polygon(
 ) {
     uint8_t poly_desc = st_niccc_read_byte(io);
     if(poly_desc == END_OF_FRAME) {
+        if(io->lod_end != 0) {
+            // Skip the other levels of the LOD group
+            io->addr = io->lod_end;
+            io->lod_end = 0;
+        }
         return 0;
     }
     if(poly_desc == NEXT_BLOCK) {
@@ -139,9 +186,36 @@ int st_niccc_read_polygon(
         io->eof = 1;
         return 0; 
     }
-    polygon->nb_vertices = poly_desc & 15;
-    polygon->color = poly_desc >> 4;
-    for(int i=0; i<polygon->nb_vertices; ++i) {
+    if(poly_desc == VERTEX_BANK) {
+        frame->nb_vertices = st_niccc_read_byte(io);
+        for(int v=0; v<frame->nb_vertices; ++v) {
+            frame->X[v] = st_niccc_read_byte(io);
+            frame->Y[v] = st_niccc_read_byte(io);
+        }
+        return st_niccc_read_polygon(io, frame, polygon);
+    }
+    int first = 0;
+    if(
+        (poly_desc & 15) == STRIP_LAST_EDGE ||
+        (poly_desc & 15) == STRIP_SECOND_EDGE
+    ) {
+        // Strip piece: starts with an edge of the previous polygon
+        int n = polygon->nb_vertices;
+        int e0 = (poly_desc & 15) == STRIP_LAST_EDGE ? n-1 : 1;
+        int e1 = (poly_desc & 15) == STRIP_LAST_EDGE ? 0   : 2;
+        int x0 = polygon->XY[2*e0];
+        int y0 = polygon->XY[2*e0+1];
+        polygon->XY[0] = polygon->XY[2*e1];
+        polygon->XY[1] = polygon->XY[2*e1+1];
+        polygon->XY[2] = x0;
+        polygon->XY[3] = y0;
+        polygon->nb_vertices = (poly_desc >> 4) + 2;
+        first = 2;
+    } else {
+        polygon->nb_vertices = poly_desc & 15;
+        polygon->color = poly_desc >> 4;
+    }
+    for(int i=first; i<polygon->nb_vertices; ++i) {
         if(frame->flags & INDEXED_BIT) {
             uint8_t index = st_niccc_read_byte(io);
             polygon->XY[2*i]   = frame->X[index];
@@ -170,6 +244,18 @@ void st_niccc_frame_clear(
     frame->flags |= CLEAR_BIT;
 }
 
+void st_niccc_frame_hold(
+    ST_NICCC_FRAME* frame
+) {
+    frame->flags |= HOLD_BIT;
+}
+
+void st_niccc_frame_motion(
+    ST_NICCC_FRAME* frame
+) {
+    frame->flags |= MOTION_BIT;
+}
+
 void st_niccc_frame_set_color(
     ST_NICCC_FRAME* frame,
     uint8_t index, uint8_t r, uint8_t g, uint8_t b
@@ -248,6 +334,29 @@ void st_niccc_write_polygon(
     }
 }
 
+void st_niccc_write_strip_indexed(
+    ST_NICCC_IO* io,
+    uint8_t strip_edge, uint8_t nb_vertices, uint8_t* vertices
+) {
+    assert(nb_vertices >= 1 && nb_vertices <= 13);
+    st_niccc_write_byte(io, strip_edge | (nb_vertices << 4));
+    for(int i=0; i<nb_vertices; ++i) {
+        st_niccc_write_byte(io, vertices[i]);
+    }
+}
+
+void st_niccc_write_strip(
+    ST_NICCC_IO* io,
+    uint8_t strip_edge, uint8_t nb_vertices, uint8_t* x, uint8_t* y
+) {
+    assert(nb_vertices >= 1 && nb_vertices <= 13);
+    st_niccc_write_byte(io, strip_edge | (nb_vertices << 4));
+    for(int i=0; i<nb_vertices; ++i) {
+        st_niccc_write_byte(io, x[i]);
+        st_niccc_write_byte(io, y[i]);
+    }
+}
+
 void st_niccc_write_triangle_indexed(
     ST_NICCC_IO* io, 
     uint8_t color, uint8_t v1, uint8_t v2, uint8_t v3
@@ -277,6 +386,27 @@ void st_niccc_write_end_of_frame(ST_NICCC_IO* io) {
     st_niccc_write_byte(io, END_OF_FRAME);
 }
 
+void st_niccc_write_lod_header(
+    ST_NICCC_IO* io, uint8_t nb_levels, uint16_t* sizes
+) {
+    st_niccc_write_byte(io, LOD_BIT);
+    st_niccc_write_byte(io, nb_levels);
+    for(int l=0; l<nb_levels; ++l) {
+        st_niccc_write_word(io, sizes[l]);
+    }
+}
+
+void st_niccc_write_vertex_bank(
+    ST_NICCC_IO* io, uint8_t nb_vertices, uint8_t* x, uint8_t* y
+) {
+    st_niccc_write_byte(io, VERTEX_BANK);
+    st_niccc_write_byte(io, nb_vertices);
+    for(int v=0; v<nb_vertices; ++v) {
+        st_niccc_write_byte(io, x[v]);
+        st_niccc_write_byte(io, y[v]);
+    }
+}
+
 void st_niccc_write_end_of_stream(ST_NICCC_IO* io) {
     st_niccc_write_byte(io, END_OF_STREAM);
 }
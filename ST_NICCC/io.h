@@ -14,6 +14,9 @@ extern "C" {
 #define CLEAR_BIT   1
 #define PALETTE_BIT 2
 #define INDEXED_BIT 4
+#define HOLD_BIT    8 /* same image as previous frame, no polygon */
+#define LOD_BIT     16 /* group of levels of detail of the same frame */
+#define MOTION_BIT  32 /* new vertex table for the polygons of the keyframe */
 
 /*
  * Special polygon codes
@@ -22,6 +25,29 @@ extern "C" {
 #define NEXT_BLOCK    0xfe
 #define END_OF_STREAM 0xfd
 
+/*
+ * Polygon codes with 1 or 2 vertices are strip pieces: a polygon
+ * that shares an edge with the previous polygon of the frame, and only
+ * sends its new vertices. The number of new vertices is in the 4 high
+ * bits, the color is the one of the previous polygon. If V is the
+ * previous polygon, the shared edge is (V[n-1],V[0]) for STRIP_LAST_EDGE
+ * and (V[1],V[2]) for STRIP_SECOND_EDGE. The new polygon starts with the
+ * shared edge, reversed, followed by the new vertices.
+ * Decoders of the original ST-NICCC format read these codes as polygons
+ * of color 0, so the encoder only writes them when asked to (strips=true
+ * in triangulate).
+ */
+#define STRIP_LAST_EDGE   1
+#define STRIP_SECOND_EDGE 2
+
+/*
+ * Polygon code for a new vertex table in an indexed frame, followed by
+ * the number of vertices and their x,y coordinates, like in the frame
+ * header. The next polygons of the frame use it, so that frames with
+ * more than 255 vertices can be indexed.
+ */
+#define VERTEX_BANK 0x00
+
 /*
  * Constants for st_niccc_open()
  */
@@ -32,6 +58,8 @@ extern "C" {
 
 /*
  * Low-level IO
+ * A counter (st_niccc_open_counter()) does not write anything,
+ * it is used to measure the size of encoded data in addr.
  */
 
 typedef struct {
@@ -42,11 +70,15 @@ typedef struct {
         uint32_t word;
         uint8_t bytes[4];
     } u;
+    size_t nb_read;   /* number of bytes of the word read from the file */
     int mode;
     int eof;
+    int lod;          /* level of detail read in LOD groups, 0 = finest */
+    uint32_t lod_end; /* address after the current LOD group, or 0 */
 } ST_NICCC_IO ;
 
 int      st_niccc_open(ST_NICCC_IO* io, const char* filename, int mode);
+void     st_niccc_open_counter(ST_NICCC_IO* io);
 void     st_niccc_close(ST_NICCC_IO* io);
 void     st_niccc_rewind(ST_NICCC_IO* io);
 uint8_t  st_niccc_read_byte(ST_NICCC_IO* io);
@@ -61,8 +93,27 @@ void     st_niccc_next_block(ST_NICCC_IO* io);
  * High-level IO
  */
 
+/*
+ * A frame with MOTION_BIT has a vertex table and no polygon. It is
+ * drawn with the polygons of the last frame that had polygons (the
+ * keyframe), using its own vertex table, that has the same vertices in
+ * the same order as the one of the keyframe, at different positions.
+ * A player can display in-between frames by interpolating the vertex
+ * tables of the previous frame and of the motion frame.
+ */
+
+/*
+ * A frame with LOD_BIT is followed by the number of levels (byte), the
+ * size of each level (word), then the levels, from finest to coarsest,
+ * each of them encoded as a complete frame. st_niccc_read_frame()
+ * reads level io->lod (or the coarsest one) and skips the other ones.
+ */
+
 typedef struct {
     uint8_t flags;
+    uint8_t nb_levels;   /* of the last LOD group, 1 if not in a group */
+    uint8_t level;       /* level read in the last LOD group */
+    uint16_t level_size; /* of the level read, 0 if not in a group */
     uint16_t cmap_flags;
     uint8_t cmap_r[16];
     uint8_t cmap_g[16];
@@ -82,6 +133,10 @@ int st_niccc_read_frame(
     ST_NICCC_IO* io, ST_NICCC_FRAME* frame
 );
 
+/*
+ * polygon needs to contain the previous polygon of the frame, to
+ * decode strip pieces.
+ */
 int st_niccc_read_polygon(
     ST_NICCC_IO* io, ST_NICCC_FRAME* frame, ST_NICCC_POLYGON* polygon
 );
@@ -90,6 +145,8 @@ int st_niccc_read_polygon(
 
 void st_niccc_frame_init(ST_NICCC_FRAME* frame);
 void st_niccc_frame_clear(ST_NICCC_FRAME* frame);
+void st_niccc_frame_hold(ST_NICCC_FRAME* frame);
+void st_niccc_frame_motion(ST_NICCC_FRAME* frame);
 
 void st_niccc_frame_set_color(
     ST_NICCC_FRAME* frame,
@@ -107,6 +164,14 @@ void st_niccc_write_frame_header(
 
 void st_niccc_write_end_of_frame(ST_NICCC_IO* io);
 
+void st_niccc_write_lod_header(
+    ST_NICCC_IO* io, uint8_t nb_levels, uint16_t* sizes
+);
+
+void st_niccc_write_vertex_bank(
+    ST_NICCC_IO* io, uint8_t nb_vertices, uint8_t* x, uint8_t* y
+);
+
 void st_niccc_write_end_of_stream(ST_NICCC_IO* io);
 
 void st_niccc_write_polygon_indexed(
@@ -119,6 +184,20 @@ void st_niccc_write_polygon(
     uint8_t color, uint8_t nb_vertices, uint8_t* x, uint8_t* y
 );
     
+/*
+ * strip_edge is STRIP_LAST_EDGE or STRIP_SECOND_EDGE, nb_vertices is
+ * the number of new vertices.
+ */
+void st_niccc_write_strip_indexed(
+    ST_NICCC_IO* io,
+    uint8_t strip_edge, uint8_t nb_vertices, uint8_t* vertices
+);
+
+void st_niccc_write_strip(
+    ST_NICCC_IO* io,
+    uint8_t strip_edge, uint8_t nb_vertices, uint8_t* x, uint8_t* y
+);
+
 void st_niccc_write_triangle_indexed(
     ST_NICCC_IO* io, 
     uint8_t color, uint8_t v1, uint8_t v2, uint8_t v3
@@ -22,3 +22,4 @@ gcc $CFLAGS -DGFX_BACKEND_GLFW ST_NICCC.c graphics.c io.c -lglfw -lGL -o ST_NICC
 gcc $CFLAGS -DGFX_BACKEND_ANSI ST_NICCC.c graphics.c io.c -o ST_NICCC_console
 gcc $CFLAGS test_gen_anim.c io.c -lm -o test_gen_anim
 gcc $CFLAGS test_ST_NICCC.c -o test_ST_NICCC
+gcc $CFLAGS -DGFX_BACKEND_MEMORY rd_ST_NICCC.c graphics.c io.c -lm -o rd_ST_NICCC
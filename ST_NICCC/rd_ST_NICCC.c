@@ -0,0 +1,218 @@
+/*
+ * Rate-distortion measurement: decodes a stream with the rasterizer of
+ * the player (memory backend of graphics.c) and compares each frame
+ * with the source frame it was vectorized from (FRAMES/frameNNNN.pgm,
+ * see vectorize.sh).
+ *
+ * usage: rd_ST_NICCC stream.bin framesdir [first_frame] [lod]
+ *   first_frame: index of the source frame of the first frame of the
+ *    stream (first_frame of triangulate, default 1)
+ *   lod: level of detail that is decoded (default 0, the finest one)
+ *
+ * Prints one line per frame: index, bytes, IoU of the dark pixels and
+ * PSNR, then a summary line that starts with '#'.
+ */
+
+#include "graphics.h"
+#include "io.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Palette components have 3 bits (see io.c), white is decoded as 224
+ */
+#define MAX_COMPONENT 224
+
+/*
+ * Pixels darker than this are the ones traced by potrace
+ */
+#define DARK 128
+
+ST_NICCC_IO io;
+ST_NICCC_FRAME frame;
+ST_NICCC_POLYGON polygon;
+
+unsigned char source[1024*1024];
+int source_width;
+int source_height;
+
+/*
+ * Loads a binary grayscale PGM image in source
+ * returns 0 if the file cannot be read
+ */
+int load_pgm(const char* filename) {
+    FILE* f = fopen(filename,"rb");
+    if(f == NULL) {
+        return 0;
+    }
+    int header[3];
+    int nb_read = 0;
+    int result = (fgetc(f) == 'P' && fgetc(f) == '5');
+    while(result && nb_read < 3) {
+        int c = fgetc(f);
+        if(c == '#') {
+            while(c != '\n' && c != EOF) {
+                c = fgetc(f);
+            }
+        } else if(c >= '0' && c <= '9') {
+            ungetc(c,f);
+            result = (fscanf(f,"%d",&header[nb_read]) == 1);
+            ++nb_read;
+        } else if(c == EOF) {
+            result = 0;
+        }
+    }
+    fgetc(f); // single whitespace before the pixels
+    source_width = header[0];
+    source_height = header[1];
+    result = result &&
+        header[2] < 256 &&
+        source_width * source_height <= (int)sizeof(source) &&
+        fread(
+            source, 1, source_width * source_height, f
+        ) == (size_t)(source_width * source_height);
+    fclose(f);
+    return result;
+}
+
+void clear_screen() {
+    // The screen is cleared with the color of palette entry 0
+    for(int i=0; i<256*256; ++i) {
+        gfx_framebuffer[3*i]   = frame.cmap_r[0];
+        gfx_framebuffer[3*i+1] = frame.cmap_g[0];
+        gfx_framebuffer[3*i+2] = frame.cmap_b[0];
+    }
+}
+
+void draw_polygons() {
+    while(st_niccc_read_polygon(&io,&frame,&polygon)) {
+        uint8_t color = polygon.color;
+        gfx_setcolor(
+            frame.cmap_r[color], frame.cmap_g[color], frame.cmap_b[color]
+        );
+        gfx_fillpoly(polygon.nb_vertices, polygon.XY);
+    }
+}
+
+int main(int argc, char** argv) {
+    if(argc < 3) {
+        fprintf(
+            stderr, "usage: %s stream.bin framesdir [first_frame] [lod]\n",
+            argv[0]
+        );
+        exit(-1);
+    }
+    const char* frames_dir = argv[2];
+    int first_frame = (argc >= 4) ? atoi(argv[3]) : 1;
+    if(!st_niccc_open(&io,argv[1],ST_NICCC_READ)) {
+        fprintf(stderr,"could not open data file\n");
+        exit(-1);
+    }
+    io.lod = (argc >= 5) ? atoi(argv[4]) : 0;
+    gfx_init();
+
+    // The first frame of the stream sets the palette (see triangulate)
+    uint32_t key_addr = 0;
+    uint32_t frame_addr = io.addr;
+    int nb_frames = 0;
+    long total_bytes = 0;
+    double total_iou = 0.0;
+    double total_mse = 0.0;
+    double min_psnr = 1e30;
+    printf("frame bytes iou psnr\n");
+    for(int f=0; st_niccc_read_frame(&io,&frame); ++f) {
+        if(frame.flags & MOTION_BIT) {
+            // Polygons of the keyframe with the new vertex table
+            draw_polygons(); // skips END_OF_FRAME
+            uint32_t end_addr = io.addr;
+            if(key_addr != 0) {
+                clear_screen();
+                io.addr = key_addr;
+                draw_polygons();
+            }
+            io.addr = end_addr;
+        } else {
+            if(!(frame.flags & HOLD_BIT)) {
+                if(frame.flags & CLEAR_BIT) {
+                    clear_screen();
+                }
+                key_addr = io.addr;
+            }
+            draw_polygons();
+        }
+        if(io.eof) {
+            break;
+        }
+        int bytes = (int)(io.addr - frame_addr);
+        if(frame.level_size != 0) {
+            // A player only reads the LOD header and the selected level,
+            // io.addr is after all the levels
+            bytes = 2 + 2*frame.nb_levels + frame.level_size;
+        }
+        frame_addr = io.addr;
+        if(f == 0) {
+            continue;
+        }
+
+        char filename[1024];
+        snprintf(
+            filename, sizeof(filename), "%s/frame%04d.pgm",
+            frames_dir, first_frame + f - 1
+        );
+        if(!load_pgm(filename)) {
+            fprintf(stderr,"could not load %s\n",filename);
+            break;
+        }
+
+        // The width of the source frame is mapped to [0,255] (see
+        // load_fig() in triangulate)
+        long nb_inter = 0;
+        long nb_union = 0;
+        double se = 0.0;
+        long nb_pixels = 0;
+        for(int py=0; py<source_height; ++py) {
+            int y = (2*py+1)*255 / (2*source_width);
+            if(y > 255) {
+                continue;
+            }
+            for(int px=0; px<source_width; ++px) {
+                int x = (2*px+1)*255 / (2*source_width);
+                unsigned char* rgb = gfx_framebuffer + 3*(y*256+x);
+                int decoded = (rgb[0] + rgb[1] + rgb[2]) * 255 /
+                    (3 * MAX_COMPONENT);
+                if(decoded > 255) {
+                    decoded = 255;
+                }
+                int expected = source[py*source_width+px];
+                double d = (double)(decoded - expected);
+                se += d*d;
+                nb_inter += (decoded < DARK && expected < DARK);
+                nb_union += (decoded < DARK || expected < DARK);
+                ++nb_pixels;
+            }
+        }
+        double iou = (nb_union == 0) ? 1.0 : (double)nb_inter/nb_union;
+        double mse = se / (double)(nb_pixels > 0 ? nb_pixels : 1);
+        double psnr = (mse == 0.0) ? 99.0 : 10.0*log10(255.0*255.0/mse);
+        printf("%d %d %.4f %.2f\n", first_frame + f - 1, bytes, iou, psnr);
+        ++nb_frames;
+        total_bytes += bytes;
+        total_iou += iou;
+        total_mse += mse;
+        if(psnr < min_psnr) {
+            min_psnr = psnr;
+        }
+    }
+    if(nb_frames == 0) {
+        fprintf(stderr,"no frame\n");
+        exit(-1);
+    }
+    double mse = total_mse / nb_frames;
+    printf(
+        "# frames: %d bytes/frame: %.1f iou: %.4f psnr: %.2f min_psnr: %.2f\n",
+        nb_frames, (double)total_bytes / nb_frames, total_iou / nb_frames,
+        (mse == 0.0) ? 99.0 : 10.0*log10(255.0*255.0/mse), min_psnr
+    );
+    return 0;
+}
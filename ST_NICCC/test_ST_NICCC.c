@@ -53,6 +53,9 @@ int      poly[30];
 #define CLEAR_BIT   1
 #define PALETTE_BIT 2
 #define INDEXED_BIT 4
+#define HOLD_BIT    8
+#define LOD_BIT     16
+#define MOTION_BIT  32
 
 
 /* returns 0 at last frame */
@@ -63,13 +66,31 @@ int read_frame() {
    ++frame;
    
     uint8_t frame_flags = next_spi_byte();
+
+    /* levels of detail: read the finest one, skip the other ones */
+    int lod_skip = 0;
+    if(frame_flags & LOD_BIT) {
+	uint8_t nb_levels = next_spi_byte();
+	printf("LOD levels:%d sizes:", nb_levels);
+	for(int l=0; l<nb_levels; ++l) {
+	    uint16_t size = next_spi_word();
+	    printf(" %d", size);
+	    if(l != 0) {
+		lod_skip += size;
+	    }
+	}
+	printf("\n");
+	frame_flags = next_spi_byte();
+    }
    
     printf(
-	   "Frame flags: %d:%c%c%c\n",
+	   "Frame flags: %d:%c%c%c%c%c\n",
 	   frame_flags,
 	   (frame_flags & CLEAR_BIT) ? 'C' : '_',
 	   (frame_flags & PALETTE_BIT) ? 'P' : '_',
-	   (frame_flags & INDEXED_BIT) ? 'I' : '_'
+	   (frame_flags & INDEXED_BIT) ? 'I' : '_',
+	   (frame_flags & HOLD_BIT) ? 'H' : '_',
+	   (frame_flags & MOTION_BIT) ? 'M' : '_'
     );
    
     if(frame_flags & CLEAR_BIT) {
@@ -120,9 +141,15 @@ int read_frame() {
 	}
     }
 
+    uint8_t nvrtx = 0;
+    uint8_t poly_col = 0;
     for(;;) {
 	uint8_t poly_desc = next_spi_byte();
 	if(poly_desc == 0xff) {
+	    while(lod_skip > 0) {
+		next_spi_byte();
+		--lod_skip;
+	    }
 	    break; // end of frame
 	}
 	if(poly_desc == 0xfe) {
@@ -136,10 +163,36 @@ int read_frame() {
 	   printf("End of stream \n");
 	   return 0; 
 	}
-	uint8_t nvrtx = poly_desc & 15;
-	uint8_t poly_col = poly_desc >> 4;
-        printf("POLY col:%d nv:%d ", poly_col, nvrtx);
-	for(int i=0; i<nvrtx; ++i) {
+	if(poly_desc == 0x00) {
+	    uint8_t nb_vertices = next_spi_byte();
+	    printf("bank nb vrtx:%d\n", nb_vertices);
+	    for(int v=0; v<nb_vertices; ++v) {
+		X[v] = next_spi_byte() >> 1;
+		Y[v] = next_spi_byte() >> 1;
+		printf("  vrtx %d: %d %d\n", v, X[v], Y[v]);
+	    }
+	    continue;
+	}
+	int first = 0;
+	if((poly_desc & 15) == 1 || (poly_desc & 15) == 2) {
+	    // strip piece: shares an edge with the previous polygon
+	    int e0 = (poly_desc & 15) == 1 ? nvrtx-1 : 1;
+	    int e1 = (poly_desc & 15) == 1 ? 0 : 2;
+	    int x0 = poly[2*e0];
+	    int y0 = poly[2*e0+1];
+	    poly[0] = poly[2*e1];
+	    poly[1] = poly[2*e1+1];
+	    poly[2] = x0;
+	    poly[3] = y0;
+	    nvrtx = (poly_desc >> 4) + 2;
+	    first = 2;
+	    printf("STRIP col:%d nv:%d ", poly_col, nvrtx);
+	} else {
+	    nvrtx = poly_desc & 15;
+	    poly_col = poly_desc >> 4;
+	    printf("POLY col:%d nv:%d ", poly_col, nvrtx);
+	}
+	for(int i=first; i<nvrtx; ++i) {
 	    if(frame_flags & INDEXED_BIT) {
 		uint8_t index = next_spi_byte();
 		poly[2*i]   = X[index];
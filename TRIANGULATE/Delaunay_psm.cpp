@@ -6559,6 +6559,7 @@ namespace GEO {
 
 #include <thread>
 #include <chrono>
+#include <atomic>
 
 #ifdef GEO_OPENMP
 #include <omp.h>
@@ -6568,7 +6569,7 @@ namespace {
     using namespace GEO;
 
     ThreadManager_var thread_manager_;
-    int running_threads_invocations_ = 0;
+    std::atomic<int> running_threads_invocations_(0);
 
     bool multithreading_initialized_ = false;
     bool multithreading_enabled_ = true;
@@ -6723,6 +6724,11 @@ namespace {
 
 namespace {
     thread_local Thread* geo_current_thread_ = nullptr;
+
+    // The WorkStealingThreadManager that runs the current thread,
+    // and the index of the deque of the current thread in it.
+    thread_local const WorkStealingThreadManager* geo_current_pool_ = nullptr;
+    thread_local index_t geo_current_pool_deque_ = 0;
 }
 
 namespace GEO {
@@ -6743,6 +6749,10 @@ namespace GEO {
     ThreadManager::~ThreadManager() {
     }
 
+    bool ThreadManager::supports_nested_threads() const {
+        return false;
+    }
+
     void ThreadManager::run_threads(ThreadGroup& threads) {
         index_t max_threads = maximum_concurrent_threads();
         if(Process::multithreading_enabled() && max_threads > 1) {
@@ -6779,6 +6789,148 @@ namespace GEO {
 
     
 
+    WorkStealingThreadManager::WorkStealingThreadManager(
+        index_t nb_threads
+    ) : nb_queued_(0), nb_steals_(0), stop_(false) {
+        if(nb_threads == 0) {
+            nb_threads = Process::number_of_cores();
+        }
+        nb_threads = std::max(nb_threads, index_t(1));
+        // One deque per worker, plus one shared by the threads
+        // that do not belong to the pool.
+        deques_ = std::vector<TaskDeque>(nb_threads);
+        for(index_t q = 0; q + 1 < nb_threads; ++q) {
+            workers_.emplace_back(
+                &WorkStealingThreadManager::worker, this, q
+            );
+        }
+    }
+
+    WorkStealingThreadManager::~WorkStealingThreadManager() {
+        {
+            std::lock_guard<std::mutex> lock(idle_lock_);
+            stop_ = true;
+        }
+        idle_.notify_all();
+        for(std::thread& w : workers_) {
+            w.join();
+        }
+    }
+
+    index_t WorkStealingThreadManager::maximum_concurrent_threads() {
+        return index_t(deques_.size());
+    }
+
+    bool WorkStealingThreadManager::supports_nested_threads() const {
+        return true;
+    }
+
+    void WorkStealingThreadManager::enter_critical_section() {
+        critical_section_.lock();
+    }
+
+    void WorkStealingThreadManager::leave_critical_section() {
+        critical_section_.unlock();
+    }
+
+    index_t WorkStealingThreadManager::current_deque() const {
+        return (geo_current_pool_ == this) ?
+            geo_current_pool_deque_ : index_t(deques_.size() - 1);
+    }
+
+    bool WorkStealingThreadManager::get_task(index_t q, Task& task) {
+        if(nb_queued_.load() == 0) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(deques_[q].lock);
+            if(!deques_[q].tasks.empty()) {
+                task = deques_[q].tasks.back();
+                deques_[q].tasks.pop_back();
+                --nb_queued_;
+                return true;
+            }
+        }
+        index_t n = index_t(deques_.size());
+        for(index_t i = 1; i < n; ++i) {
+            TaskDeque& victim = deques_[(q + i) % n];
+            std::lock_guard<std::mutex> lock(victim.lock);
+            if(!victim.tasks.empty()) {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                --nb_queued_;
+                ++nb_steals_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void WorkStealingThreadManager::run_task(const Task& task) {
+        Thread* prev = Thread::current();
+        set_current_thread(task.thread);
+        task.thread->run();
+        set_current_thread(prev);
+        task.pending->fetch_sub(1, std::memory_order_release);
+    }
+
+    void WorkStealingThreadManager::worker(index_t q) {
+        geo_current_pool_ = this;
+        geo_current_pool_deque_ = q;
+        Task task;
+        for(;;) {
+            if(get_task(q, task)) {
+                run_task(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idle_lock_);
+            idle_.wait(
+                lock, [this]() { return stop_ || nb_queued_.load() != 0; }
+            );
+            if(stop_) {
+                return;
+            }
+        }
+    }
+
+    void WorkStealingThreadManager::run_concurrent_threads(
+        ThreadGroup& threads, index_t max_threads
+    ) {
+        geo_argused(max_threads);
+        std::atomic<index_t> pending(index_t(threads.size()));
+        index_t q = current_deque();
+        {
+            std::lock_guard<std::mutex> lock(deques_[q].lock);
+            // Pushed in reverse order, so that the owner pops the
+            // first ones and the thieves steal the last ones.
+            for(index_t i = index_t(threads.size()); i > 0; --i) {
+                Thread* T = threads[i-1];
+                set_thread_id(T, i-1);
+                deques_[q].tasks.push_back(Task{T, &pending});
+            }
+            nb_queued_ += index_t(threads.size());
+        }
+        {
+            // Acquiring the lock makes sure that no worker is
+            // between testing nb_queued_ and waiting (lost wakeup).
+            std::lock_guard<std::mutex> lock(idle_lock_);
+        }
+        idle_.notify_all();
+
+        // Help until all the tasks of this group are done. The tasks
+        // that are run here may belong to other groups.
+        Task task;
+        while(pending.load(std::memory_order_acquire) != 0) {
+            if(get_task(q, task)) {
+                run_task(task);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    
+
     namespace Process {
 
         // OS dependent functions implemented in process_unix.cpp and
@@ -6920,6 +7072,13 @@ namespace GEO {
             thread_manager_->leave_critical_section();
         }
 
+        bool supports_nested_threads() {
+            return (
+                thread_manager_ != nullptr &&
+                thread_manager_->supports_nested_threads()
+            );
+        }
+
         bool is_running_threads() {
 #ifdef GEO_OPENMP
             return (
@@ -7111,6 +7270,20 @@ namespace {
     
 }
 
+namespace {
+
+    /**
+     * \brief Tests whether a parallel region should run sequentially,
+     *  i.e. when it is nested and the ThreadManager cannot nest regions.
+     */
+    bool run_sequentially() {
+        return (
+            Process::is_running_threads() &&
+            !Process::supports_nested_threads()
+        );
+    }
+}
+
 namespace GEO {
 
     void parallel_for(
@@ -7130,7 +7303,7 @@ namespace GEO {
 	nb_threads = std::max(index_t(1), nb_threads);
 	
         index_t batch_size = (to - from) / nb_threads;
-        if(Process::is_running_threads() || nb_threads == 1) {
+        if(run_sequentially() || nb_threads == 1) {
             for(index_t i = from; i < to; i++) {
                 func(i);
             }
@@ -7185,7 +7358,7 @@ namespace GEO {
 	nb_threads = std::max(index_t(1), nb_threads);
 	
         index_t batch_size = (to - from) / nb_threads;
-        if(Process::is_running_threads() || nb_threads == 1) {
+        if(run_sequentially() || nb_threads == 1) {
 	    func(from, to);
         } else {
             ThreadGroup threads;
@@ -7214,7 +7387,7 @@ namespace GEO {
 	std::function<void()> f1,
 	std::function<void()> f2
     ) {
-        if(Process::is_running_threads()) {
+        if(run_sequentially()) {
 	    f1();
 	    f2();
         } else {
@@ -7232,7 +7405,7 @@ namespace GEO {
 	std::function<void()> f3,
 	std::function<void()> f4
     ) {
-        if(Process::is_running_threads()) {
+        if(run_sequentially()) {
 	    f1();
 	    f2();
 	    f3();
@@ -7258,7 +7431,7 @@ namespace GEO {
 	std::function<void()> f7,
 	std::function<void()> f8	 
     ) {
-        if(Process::is_running_threads()) {
+        if(run_sequentially()) {
 	    f1();
 	    f2();
 	    f3();
@@ -9848,6 +10021,10 @@ namespace {
     };
 
     static Pools pools_;
+
+    
+    
+    thread_local ExpansionPool* current_expansion_pool_ = nullptr;
     
     
     
@@ -10307,27 +10484,129 @@ namespace GEO {
         expansion_splitter_ += 1.0;
     }
 
+    ExpansionPool::ExpansionPool() :
+        free_list_(MAX_ITEM_SIZE, nullptr),
+        nb_live_(0),
+        nb_allocations_(0),
+        nb_bytes_(0),
+        reserved_bytes_(0) {
+    }
+
+    ExpansionPool::~ExpansionPool() {
+        geo_debug_assert(nb_live_ == 0);
+        for(index_t i=0; i<chunks_.size(); ++i) {
+            delete[] chunks_[i];
+        }
+    }
+
+    void* ExpansionPool::malloc(size_t size) {
+        ++nb_live_;
+        ++nb_allocations_;
+        nb_bytes_ += size;
+        if(size >= MAX_ITEM_SIZE) {
+            return ::malloc(size);
+        }
+        if(free_list_[size] == nullptr) {
+            new_chunk(size);
+        }
+        Memory::pointer result = free_list_[size];
+        free_list_[size] = *reinterpret_cast<Memory::pointer*>(result);
+        return result;
+    }
+
+    void ExpansionPool::free(void* ptr, size_t size) {
+        geo_debug_assert(nb_live_ != 0);
+        --nb_live_;
+        if(size >= MAX_ITEM_SIZE) {
+            ::free(ptr);
+            return;
+        }
+        *reinterpret_cast<Memory::pointer*>(ptr) = free_list_[size];
+        free_list_[size] = Memory::pointer(ptr);
+    }
+
+    void ExpansionPool::clear() {
+        if(nb_live_ != 0) {
+            return;
+        }
+        for(index_t i=0; i<chunks_.size(); ++i) {
+            delete[] chunks_[i];
+        }
+        chunks_.resize(0);
+        free_list_.assign(MAX_ITEM_SIZE, nullptr);
+        reserved_bytes_ = 0;
+    }
+
+    void ExpansionPool::new_chunk(size_t item_size) {
+        Memory::pointer chunk =
+            new Memory::byte[item_size * NB_ITEMS_PER_CHUNK];
+        for(index_t i=0; i<NB_ITEMS_PER_CHUNK; ++i) {
+            Memory::pointer item = chunk + item_size * size_t(i);
+            *reinterpret_cast<Memory::pointer*>(item) =
+                (i+1 == NB_ITEMS_PER_CHUNK) ?
+                free_list_[item_size] : item + item_size;
+        }
+        free_list_[item_size] = chunk;
+        chunks_.push_back(chunk);
+        reserved_bytes_ += item_size * NB_ITEMS_PER_CHUNK;
+    }
+
+    ExpansionPool* ExpansionPool::current() {
+        return current_expansion_pool_;
+    }
+
+    ExpansionPool::Scope::Scope(ExpansionPool& pool) :
+        prev_(current_expansion_pool_) {
+        current_expansion_pool_ = &pool;
+    }
+
+    ExpansionPool::Scope::~Scope() {
+        current_expansion_pool_ = prev_;
+    }
+
+    
+
     static Process::spinlock expansions_lock = GEOGRAM_SPINLOCK_INIT;
     
+    // Each expansion on the heap is preceded by a pointer to the
+    // ExpansionPool it was allocated from (nullptr for pools_).
+    static const size_t EXPANSION_HEADER_BYTES = sizeof(ExpansionPool*);
+    
     expansion* expansion::new_expansion_on_heap(index_t capa) {
-	Process::acquire_spinlock(expansions_lock);
+        size_t size = expansion::bytes(capa) + EXPANSION_HEADER_BYTES;
+        ExpansionPool* pool = ExpansionPool::current();
 #ifdef PCK_STATS
+	Process::acquire_spinlock(expansions_lock);
             if(capa >= expansion_length_histo_.size()) {
                 expansion_length_histo_.resize(capa + 1);
             }
             expansion_length_histo_[capa]++;
-#endif            
-        Memory::pointer addr = Memory::pointer(
-            pools_.malloc(expansion::bytes(capa))
-        );
 	Process::release_spinlock(expansions_lock);
-        expansion* result = new(addr)expansion(capa);
+#endif            
+        Memory::pointer addr = nullptr;
+        if(pool != nullptr) {
+            // No lock: the current pool is used by this thread only
+            addr = Memory::pointer(pool->malloc(size));
+        } else {
+            Process::acquire_spinlock(expansions_lock);
+            addr = Memory::pointer(pools_.malloc(size));
+            Process::release_spinlock(expansions_lock);
+        }
+        *reinterpret_cast<ExpansionPool**>(addr) = pool;
+        expansion* result = new(addr + EXPANSION_HEADER_BYTES)expansion(capa);
         return result;
     }
 
     void expansion::delete_expansion_on_heap(expansion* e) {
+        size_t size = expansion::bytes(e->capacity()) + EXPANSION_HEADER_BYTES;
+        Memory::pointer addr = Memory::pointer(e) - EXPANSION_HEADER_BYTES;
+        ExpansionPool* pool = *reinterpret_cast<ExpansionPool**>(addr);
+        if(pool != nullptr) {
+            pool->free(addr, size);
+            return;
+        }
 	Process::acquire_spinlock(expansions_lock);	
-        pools_.free(e, expansion::bytes(e->capacity()));
+        pools_.free(addr, size);
 	Process::release_spinlock(expansions_lock);	
     }
 
@@ -19181,56 +19460,152 @@ inline int det_compare_4d_filter( const double* p0, const double* p1, const doub
 
 #include <vector>
 #include <algorithm>
+#include <mutex>
+#include <cstring>
 
 namespace {
     using namespace GEO;
 
-#ifdef PCK_STATS
-    inline double percent(Numeric::int64 a, Numeric::int64 b) {
+    inline double percent(Numeric::uint64 a, Numeric::uint64 b) {
         return 100.0 * double(a) / double(b);
     }
-#endif
-    
+
+    typedef std::atomic<Numeric::uint64> PredicateCounter;
+
+    const index_t NB_PREDICATE_COUNTERS =
+        PCK::PredicateStats::MAX_PREDICATES *
+        PCK::PredicateStats::NB_COUNTERS;
+
+    std::mutex& predicate_stats_mutex() {
+        static std::mutex result;
+        return result;
+    }
+
+    /**
+     * \brief The counters of all the predicates for one thread.
+     * \details They are registered during the lifetime of the thread,
+     *  then merged into the counters of the terminated threads.
+     */
+    struct ThreadPredicateCounters {
+        ThreadPredicateCounters();
+        ~ThreadPredicateCounters();
+        PredicateCounter counters[NB_PREDICATE_COUNTERS];
+    };
+
+    std::vector<ThreadPredicateCounters*>& all_thread_predicate_counters() {
+        static std::vector<ThreadPredicateCounters*> result;
+        return result;
+    }
+
+    Numeric::uint64 terminated_threads_predicate_counters[
+        NB_PREDICATE_COUNTERS
+    ];
+
+    ThreadPredicateCounters::ThreadPredicateCounters() {
+        for(index_t i=0; i<NB_PREDICATE_COUNTERS; ++i) {
+            counters[i].store(0, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(predicate_stats_mutex());
+        all_thread_predicate_counters().push_back(this);
+    }
+
+    ThreadPredicateCounters::~ThreadPredicateCounters() {
+        std::lock_guard<std::mutex> lock(predicate_stats_mutex());
+        for(index_t i=0; i<NB_PREDICATE_COUNTERS; ++i) {
+            terminated_threads_predicate_counters[i] +=
+                counters[i].load(std::memory_order_relaxed);
+        }
+        std::vector<ThreadPredicateCounters*>& all =
+            all_thread_predicate_counters();
+        all.erase(std::find(all.begin(), all.end(), this));
+    }
 }
 
 namespace GEO {
     namespace PCK {
 
 #ifdef PCK_STATS
-        
+        bool PredicateStats::enabled_ = true;
+#else
+        bool PredicateStats::enabled_ = false;
+#endif
         PredicateStats* PredicateStats::first_ = nullptr;
+        index_t PredicateStats::nb_ = 0;
         
         PredicateStats::PredicateStats(
             const char* name
-        ) : next_(first_),
-            name_(name),
-            invoke_count_(0),
-            exact_count_(0),
-            SOS_count_(0) {
+        ) : name_(name) {
+            std::lock_guard<std::mutex> lock(predicate_stats_mutex());
+            geo_assert(nb_ < MAX_PREDICATES);
+            id_ = nb_;
+            ++nb_;
+            next_ = first_;
             first_ = this;
         }
 
+        std::atomic<Numeric::uint64>& PredicateStats::thread_counter(
+            index_t id, Counter c
+        ) {
+            static thread_local ThreadPredicateCounters counters;
+            return counters.counters[id * NB_COUNTERS + index_t(c)];
+        }
+
+        Numeric::uint64 PredicateStats::count(Counter c) const {
+            index_t i = id_ * NB_COUNTERS + index_t(c);
+            std::lock_guard<std::mutex> lock(predicate_stats_mutex());
+            Numeric::uint64 result = terminated_threads_predicate_counters[i];
+            for(ThreadPredicateCounters* T : all_thread_predicate_counters()) {
+                result += T->counters[i].load(std::memory_order_relaxed);
+            }
+            return result;
+        }
+
+        void PredicateStats::reset_all() {
+            std::lock_guard<std::mutex> lock(predicate_stats_mutex());
+            for(index_t i=0; i<NB_PREDICATE_COUNTERS; ++i) {
+                terminated_threads_predicate_counters[i] = 0;
+            }
+            for(ThreadPredicateCounters* T : all_thread_predicate_counters()) {
+                for(index_t i=0; i<NB_PREDICATE_COUNTERS; ++i) {
+                    T->counters[i].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+
         void PredicateStats::show_all_stats() {
-            std::vector<PredicateStats*> all_stats;
+            if(!enabled_) {
+                Logger::out("Stats")
+                    << "Predicate stats are disabled "
+                    << "(see PCK::PredicateStats::set_enabled())"
+                    << std::endl;
+                return;
+            }
+            std::vector<std::pair<Numeric::uint64, PredicateStats*> > all;
             for(
                 PredicateStats* stats = first_;
                 stats != nullptr; stats = stats->next_) {
-                all_stats.push_back(stats);
+                all.push_back(std::make_pair(stats->count(INVOKE), stats));
             }
             std::sort(
-                all_stats.begin(), all_stats.end(),
-                [](const PredicateStats* a, const PredicateStats* b)->bool {
-                    return (a->invoke_count_ > b->invoke_count_);
+                all.begin(), all.end(),
+                [](const std::pair<Numeric::uint64, PredicateStats*>& a,
+                   const std::pair<Numeric::uint64, PredicateStats*>& b
+                )->bool {
+                    return (a.first > b.first);
                 }
             );
-            for(PredicateStats* stats : all_stats) {
-                stats->show_stats();
+            for(auto& it : all) {
+                it.second->show_stats();
             }
         }
 
         void PredicateStats::show_stats() {
+            Numeric::uint64 invoke_count = count(INVOKE);
+            Numeric::uint64 filter_failure_count = count(FILTER_FAILURE);
+            Numeric::uint64 exact_count = count(EXACT);
+            Numeric::uint64 SOS_count = count(SOS);
 
-            if(invoke_count_ == 0) {
+            if(invoke_count == 0) {
                 return;
             }
             
@@ -19238,37 +19613,49 @@ namespace GEO {
                                      << name_ << std::endl;
             
             Logger::out("PCK stats") 
-                << String::format("   invocations : %12ld",
-                                  Numeric::int64(invoke_count_))
+                << String::format("   invocations : %12lu",
+                                  (unsigned long)(invoke_count))
                 << std::endl;
 
-            Numeric::int64 filter_hit_count = invoke_count_ - exact_count_;
+            // Predicates that do not log filter failures
+            // fall back to exact arithmetics when the filter fails
+            Numeric::uint64 filter_hit_count = invoke_count - (
+                filter_failure_count != 0 ? filter_failure_count : exact_count
+            );
             
             Logger::out("PCK stats")
-                << String::format("    filter hit : %12ld (%3.2f %%)",
-                                  Numeric::int64(filter_hit_count),
-                                  percent(filter_hit_count, invoke_count_)
+                << String::format("    filter hit : %12lu (%3.2f %%)",
+                                  (unsigned long)(filter_hit_count),
+                                  percent(filter_hit_count, invoke_count)
                                  )
                 << std::endl;
 
+            if(filter_failure_count != 0) {
+                Logger::out("PCK stats")
+                << String::format("filter failure : %12lu (%3.2f %%)",
+                                  (unsigned long)(filter_failure_count),
+                                  percent(filter_failure_count, invoke_count)
+                                 )
+                << std::endl;
+            }
+
             Logger::out("PCK stats")
-                << String::format("         exact : %12ld (%3.2f %%)",
-                                  Numeric::int64(exact_count_),
-                                  percent(exact_count_, invoke_count_)
+                << String::format("         exact : %12lu (%3.2f %%)",
+                                  (unsigned long)(exact_count),
+                                  percent(exact_count, invoke_count)
                                  )
                 << std::endl;
             
-            if(SOS_count_ != 0 || strstr(name_, "SOS") != nullptr) {
+            if(SOS_count != 0 || strstr(name_, "SOS") != nullptr) {
                 Logger::out("PCK stats")                
-                << String::format("           SOS : %12ld (%3.2f %%)",
-                                  Numeric::int64(SOS_count_),
-                                  percent(SOS_count_, invoke_count_)
+                << String::format("           SOS : %12lu (%3.2f %%)",
+                                  (unsigned long)(SOS_count),
+                                  percent(SOS_count, invoke_count)
                                  )
                 << std::endl;
             }
             Logger::out("PCK stats") << std::endl;               
         }
-#endif
         
     }
 }
@@ -20910,6 +21297,7 @@ namespace GEO {
             stats_orient2d.log_invoke();
             Sign result = Sign(orient_2d_filter(p0, p1, p2));
             if(result == 0) {
+                stats_orient2d.log_filter_failure();
                 result = orient_2d_exact(p0, p1, p2);
             }
             return result;
@@ -21473,6 +21861,7 @@ namespace GEO {
                     );
                 }
             }
+            stats.log_filter_failure();
             stats.log_exact();
 #ifdef GEO_HAS_BIG_STACK            
             const expansion& Delta = expansion_det3x3(
@@ -21533,6 +21922,7 @@ namespace GEO {
                 }
             }
 
+            stats.log_filter_failure();
             stats.log_exact();
             
             vec3HE U = p1-p0;
@@ -21588,6 +21978,7 @@ namespace GEO {
                 }
             }
 
+            stats.log_filter_failure();
             stats.log_exact();
             
             Sign result = ZERO;
@@ -21768,6 +22159,7 @@ namespace GEO {
             }
 
             // Exact
+            stats.log_filter_failure();
             stats.log_exact();
             {
                 expansion_nt L1(expansion_nt::DIFF, l0, l3);
@@ -21886,6 +22278,7 @@ namespace GEO {
             // (expansions allocated on the stack, better for
             // multithreading)
         exact:
+            stats.log_filter_failure();
             stats.log_exact();
             
             const expansion& Ux = expansion_diff(p2.x, p1.x);
@@ -32868,7 +33261,11 @@ namespace GEO {
         ncnstr_(0),
         delaunay_(true),
         exact_incircle_(true),
-        exact_intersections_(true) {
+        exact_intersections_(true),
+        nb_locate_(0),
+        nb_locate_traversed_T_(0),
+        nb_swaps_(0),
+        defer_Delaunay_(false) {
     }
 
     CDTBase2d::~CDTBase2d() {
@@ -32878,10 +33275,12 @@ namespace GEO {
         nv_ = 0;
         ncnstr_ = 0;
         T_.resize(0);
+#ifndef CDT_PACKED_TRIANGLES
         Tadj_.resize(0);
-        v2T_.resize(0);
         Tflags_.resize(0);
         Tecnstr_first_.resize(0);
+#endif
+        v2T_.resize(0);
         ecnstr_val_.resize(0);
         ecnstr_next_.resize(0);
         Tnext_.resize(0);
@@ -33051,8 +33450,11 @@ namespace GEO {
             // Step 2: constrain edges
             constrain_edges(i,k,Q,N);
             
-            // Step 3: restore Delaunay condition
-            if(delaunay_) {
+            // Step 3: restore Delaunay condition (or later, once for
+            // all the constraints, in insert_constraints())
+            if(delaunay_ && defer_Delaunay_) {
+                N.clear();
+            } else if(delaunay_) {
                 Delaunayize_new_edges(N);
 #ifdef CDT_DEBUG                
                 debug_check_geometry();
@@ -33110,6 +33512,86 @@ namespace GEO {
 #endif        
     }
 
+    void CDTBase2d::insert_constraints(
+        index_t nb_constraints, const index_t* vertices
+    ) {
+        // While the constraints are inserted, Tset() marks all the
+        // triangles that are created or modified. The Delaunay condition
+        // is restored on their edges afterwards.
+        defer_Delaunay_ = delaunay_;
+        for(index_t c=0; c<nb_constraints; ++c) {
+            insert_constraint(vertices[2*c], vertices[2*c+1]);
+        }
+        if(defer_Delaunay_) {
+            defer_Delaunay_ = false;
+            Delaunayize_touched_triangles();
+#ifdef CDT_DEBUG                
+            debug_check_geometry();
+#endif                
+        }
+    }
+
+    void CDTBase2d::Delaunayize_touched_triangles() {
+        vector<Edge> S;
+        for(index_t t=0; t<nT(); ++t) {
+            if(Tflag_is_set(t, T_TOUCHED_FLAG)) {
+                Treset_flag(t, T_TOUCHED_FLAG);
+                for(index_t le=0; le<3; ++le) {
+                    index_t t2 = Tadj(t,le);
+                    // Edges between two touched triangles are
+                    // pushed once.
+                    if(
+                        t2 != index_t(-1) && !Tedge_is_constrained(t,le) &&
+                        (t2 < t || !Tflag_is_set(t2, T_TOUCHED_FLAG))
+                    ) {
+                        S.push_back(
+                            std::make_pair(Tv(t,(le+1)%3), Tv(t,(le+2)%3))
+                        );
+                    }
+                }
+            }
+        }
+
+        // Lawson flips, the four edges around a flipped edge are
+        // checked again.
+        index_t count = 0;
+        while(!S.empty()) {
+            // NASA programming style: all loops have
+            // a maximum number of iterations
+            ++count;
+            if(count > 100*nT()) {
+                Logger::warn("CDT2d")
+                    << "Emergency exit in Delaunayize_touched_triangles()"
+                    << std::endl;
+                break;
+            }
+            Edge E = S.back();
+            S.pop_back();
+            index_t t1 = find_edge(E.first, E.second);
+            if(t1 == index_t(-1) || Tedge_is_constrained(t1,0)) {
+                continue;
+            }
+            index_t t2 = Tadj(t1,0);
+            if(t2 == index_t(-1)) {
+                continue;
+            }
+            if(!exact_incircle_ && !is_convex_quad(t1)) {
+                continue;
+            }
+            index_t v0 = Tv(t1,0);
+            index_t v1 = Tv(t1,1);
+            index_t v2 = Tv(t1,2);
+            index_t v3 = Tv(t2,Tadj_find(t2,t1));
+            if(Sign(incircle(v0,v1,v2,v3)*orient_012_) == POSITIVE) {
+                swap_edge(t1);
+                S.push_back(std::make_pair(v0,v1));
+                S.push_back(std::make_pair(v1,v3));
+                S.push_back(std::make_pair(v3,v2));
+                S.push_back(std::make_pair(v2,v0));
+            }
+        }
+    }
+
     void CDTBase2d::Delaunayize_vertex_neighbors(index_t v) {
         CDT_LOG("Delaunayize_vertex_neighbors " << v);
         
@@ -33502,6 +33984,8 @@ namespace GEO {
             o = o_local;
         }
 
+        ++nb_locate_;
+        
         // Efficient locate, "walking the triangulation"
         index_t nb_traversed_t = 0;
         index_t t_pred = nT()+1; // Needs to be different from index_t(-1)
@@ -33512,6 +33996,7 @@ namespace GEO {
     still_walking:
         {
             ++nb_traversed_t;
+            ++nb_locate_traversed_T_;
 
             // Infinite loop are not supposed to happen, but
             // let us detect them, just in case...
@@ -33699,14 +34184,18 @@ namespace GEO {
                 Tedge_cnstr_first(t,1),
                 Tedge_cnstr_first(t,2)
             );
-            Tflags_[t_new] = 0;
+            Tflags(t_new) = 0;
         }
 
         // Step 3: resize arrays
+#ifdef CDT_PACKED_TRIANGLES
+        T_.resize(nT_new);
+#else
         T_.resize(3*nT_new);
         Tadj_.resize(3*nT_new);
         Tflags_.resize(nT_new);
         Tecnstr_first_.resize(3*nT_new);
+#endif
         Tnext_.resize(nT_new);
         Tprev_.resize(nT_new);
 
@@ -33732,6 +34221,10 @@ namespace GEO {
         index_t v3 = Tv(t1,(le1+2)%3);
         index_t t1_adj2 = Tadj(t1,(le1+1)%3);
         index_t t1_adj3 = Tadj(t1,(le1+2)%3);
+        // Constraints of the border edges cannot be retrieved from
+        // the neighbors by Tadj_back_connect(), keep them here.
+        index_t t1_cnstr2 = Tedge_cnstr_first(t1,(le1+1)%3);
+        index_t t1_cnstr3 = Tedge_cnstr_first(t1,(le1+2)%3);
         if(t2 != index_t(-1)) {
             CDT_LOG("  insert vertex in internal edge");
             // New vertex is on an edge of t1 and t1 has a neighbor
@@ -33744,12 +34237,14 @@ namespace GEO {
             index_t v4 = Tv(t2,le2);
             index_t t2_adj2 = Tadj(t2,(le2+1)%3);
             index_t t2_adj3 = Tadj(t2,(le2+2)%3);
+            index_t t2_cnstr2 = Tedge_cnstr_first(t2,(le2+1)%3);
+            index_t t2_cnstr3 = Tedge_cnstr_first(t2,(le2+2)%3);
             index_t t3 = Tnew();
             index_t t4 = Tnew();
-            Tset(t1,v,v1,v2,t1_adj3,t2,t4);
-            Tset(t2,v,v2,v4,t2_adj2,t3,t1);
-            Tset(t3,v,v4,v3,t2_adj3,t4,t2);
-            Tset(t4,v,v3,v1,t1_adj2,t1,t3);
+            Tset(t1,v,v1,v2,t1_adj3,t2,t4,t1_cnstr3);
+            Tset(t2,v,v2,v4,t2_adj2,t3,t1,t2_cnstr2);
+            Tset(t3,v,v4,v3,t2_adj3,t4,t2,t2_cnstr3);
+            Tset(t4,v,v3,v1,t1_adj2,t1,t3,t1_cnstr2);
             Tadj_back_connect(t1,0,t1);
             Tadj_back_connect(t2,0,t2);
             Tadj_back_connect(t3,0,t2);
@@ -33770,8 +34265,8 @@ namespace GEO {
             // accross that edge. Discard t1 and replace it with two
             // new triangles (recycle t1).
             t2 = Tnew();
-            Tset(t1,v,v1,v2,t1_adj3,index_t(-1),t2);
-            Tset(t2,v,v3,v1,t1_adj2,t1,index_t(-1));
+            Tset(t1,v,v1,v2,t1_adj3,index_t(-1),t2,t1_cnstr3);
+            Tset(t2,v,v3,v1,t1_adj2,t1,index_t(-1),t1_cnstr2);
             Tadj_back_connect(t1,0,t1);
             Tadj_back_connect(t2,0,t1);            
             Tset_edge_cnstr_first(t1,1,cnstr_first);
@@ -33793,11 +34288,16 @@ namespace GEO {
         index_t adj1 = Tadj(t1,0);
         index_t adj2 = Tadj(t1,1);
         index_t adj3 = Tadj(t1,2);
+        // Constraints of the border edges cannot be retrieved from
+        // the neighbors by Tadj_back_connect(), keep them here.
+        index_t cnstr1 = Tedge_cnstr_first(t1,0);
+        index_t cnstr2 = Tedge_cnstr_first(t1,1);
+        index_t cnstr3 = Tedge_cnstr_first(t1,2);
         index_t t2 = Tnew();
         index_t t3 = Tnew();
-        Tset(t1,v,v2,v3,adj1,t2,t3);
-        Tset(t2,v,v3,v1,adj2,t3,t1);
-        Tset(t3,v,v1,v2,adj3,t1,t2);
+        Tset(t1,v,v2,v3,adj1,t2,t3,cnstr1);
+        Tset(t2,v,v3,v1,adj2,t3,t1,cnstr2);
+        Tset(t3,v,v1,v2,adj3,t1,t2,cnstr3);
         Tadj_back_connect(t1,0,t1);
         Tadj_back_connect(t2,0,t1);
         Tadj_back_connect(t3,0,t1);
@@ -33810,6 +34310,7 @@ namespace GEO {
     
     void CDTBase2d::swap_edge(index_t t1, bool swap_t1_t2) {
         geo_debug_assert(!Tedge_is_constrained(t1,0));
+        ++nb_swaps_;
         index_t v1 = Tv(t1,0);
         index_t v2 = Tv(t1,1);
         index_t v3 = Tv(t1,2);                        
@@ -33826,16 +34327,34 @@ namespace GEO {
         
         index_t t2_adj2 = Tadj(t2,(le2+1)%3);
         index_t t2_adj3 = Tadj(t2,(le2+2)%3);
+        // Constraints of the border edges cannot be retrieved from
+        // the neighbors by Tadj_back_connect(), keep them here.
+        index_t t1_cnstr2 = Tedge_cnstr_first(t1,1);
+        index_t t1_cnstr3 = Tedge_cnstr_first(t1,2);
+        index_t t2_cnstr2 = Tedge_cnstr_first(t2,(le2+1)%3);
+        index_t t2_cnstr3 = Tedge_cnstr_first(t2,(le2+2)%3);
         if(swap_t1_t2) {
-            Tset(t2,v1,v4,v3,t2_adj3,t1_adj2,t1);
-            Tset(t1,v1,v2,v4,t2_adj2,t2,t1_adj3);
+            Tset(
+                t2,v1,v4,v3,t2_adj3,t1_adj2,t1,
+                t2_cnstr3,t1_cnstr2,index_t(-1)
+            );
+            Tset(
+                t1,v1,v2,v4,t2_adj2,t2,t1_adj3,
+                t2_cnstr2,index_t(-1),t1_cnstr3
+            );
             Tadj_back_connect(t2,0,t2);
             Tadj_back_connect(t2,1,t1);
             Tadj_back_connect(t1,0,t2);
             Tadj_back_connect(t1,2,t1);
         } else {
-            Tset(t1,v1,v4,v3,t2_adj3,t1_adj2,t2);
-            Tset(t2,v1,v2,v4,t2_adj2,t1,t1_adj3);
+            Tset(
+                t1,v1,v4,v3,t2_adj3,t1_adj2,t2,
+                t2_cnstr3,t1_cnstr2,index_t(-1)
+            );
+            Tset(
+                t2,v1,v2,v4,t2_adj2,t1,t1_adj3,
+                t2_cnstr2,index_t(-1),t1_cnstr3
+            );
             Tadj_back_connect(t1,0,t2);
             Tadj_back_connect(t1,1,t1);
             Tadj_back_connect(t2,0,t2);
@@ -34269,6 +34788,103 @@ namespace GEO {
 
     
 
+    OrientCache::OrientCache() :
+        mask_(0),
+        size_(0),
+        max_size_(index_t(-1)),
+        stamp_(1),
+        nb_lookups_(0),
+        nb_hits_(0),
+        nb_probes_(0) {
+    }
+
+    void OrientCache::clear() {
+        size_ = 0;
+        ++stamp_;
+        // Stamp wrapped around, old entries could be seen as valid.
+        if(stamp_ == 0) {
+            for(Entry& E: entries_) {
+                E.stamp = 0;
+            }
+            stamp_ = 1;
+        }
+    }
+
+    void OrientCache::set_max_size(index_t max_size) {
+        max_size_ = max_size;
+        if(size_ > max_size_) {
+            clear();
+        }
+        if(max_size_ == 0) {
+            entries_.clear();
+            mask_ = 0;
+        }
+    }
+
+    void OrientCache::insert(const trindex& K, Sign value) {
+        if(max_size_ == 0) {
+            return;
+        }
+        if(size_ >= max_size_) {
+            clear();
+        }
+        // Keep load factor below 1/2
+        if(2*(size_+1) > index_t(entries_.size())) {
+            grow();
+        }
+        insert_entry(K, Numeric::int32(value));
+    }
+
+    void OrientCache::insert_entry(const trindex& K, Numeric::int32 sign) {
+        for(index_t i = hash(K);; i = (i+1) & mask_) {
+            Entry& E = entries_[i];
+            if(E.stamp != stamp_) {
+                E.indices[0] = K.indices[0];
+                E.indices[1] = K.indices[1];
+                E.indices[2] = K.indices[2];
+                E.stamp = stamp_;
+                E.sign = sign;
+                ++size_;
+                return;
+            }
+            if(
+                E.indices[0] == K.indices[0] &&
+                E.indices[1] == K.indices[1] &&
+                E.indices[2] == K.indices[2]
+            ) {
+                E.sign = sign;
+                return;
+            }
+        }
+    }
+
+    void OrientCache::grow() {
+        vector<Entry> old_entries;
+        old_entries.swap(entries_);
+        Numeric::uint32 old_stamp = stamp_;
+        index_t new_size = std::max(index_t(old_entries.size()*2), index_t(1024));
+        entries_.resize(new_size);
+        for(Entry& E: entries_) {
+            E.stamp = 0;
+        }
+        mask_ = new_size - 1;
+        size_ = 0;
+        stamp_ = 1;
+        for(const Entry& E: old_entries) {
+            if(E.stamp == old_stamp) {
+                insert_entry(
+                    trindex(
+                        E.indices[0], E.indices[1], E.indices[2],
+                        trindex::KEEP_ORDER
+                    ),
+                    E.sign
+                );
+            }
+        }
+    }
+
+    /*************************************************************************/
+    
     ExactCDT2d::ExactCDT2d():
         use_pred_cache_insert_buffer_(false) {
 #ifdef GEOGRAM_USE_EXACT_NT
@@ -34296,6 +34912,8 @@ namespace GEO {
 #ifndef GEOGRAM_USE_EXACT_NT
         length_.resize(0);
 #endif        
+        // All the intersections are destroyed, release their storage
+        expansion_pool_.clear();
     }
     
     void ExactCDT2d::create_enclosing_quad(
@@ -34337,6 +34955,39 @@ namespace GEO {
         return v;
     }
 
+    void ExactCDT2d::insert(
+        index_t nb_points, const double* points, index_t* indices
+    ) {
+        if(nb_points == 0) {
+            return;
+        }
+        // Hilbert order rather than BRIO, that uses a random shuffle:
+        // the result (vertex numbering) is reproducible.
+        vector<index_t> sorted_indices(nb_points);
+        for(index_t i=0; i<nb_points; ++i) {
+            sorted_indices[i] = i;
+        }
+        compute_Hilbert_order(
+            nb_points, points, sorted_indices, 0, nb_points, 2, 2
+        );
+        point_.reserve(point_.size()+nb_points);
+        id_.reserve(id_.size()+nb_points);
+#ifndef GEOGRAM_USE_EXACT_NT
+        length_.reserve(length_.size()+nb_points);
+#endif
+        v2T_.reserve(v2T_.size()+nb_points);
+        index_t hint = index_t(-1);
+        for(index_t i=0; i<nb_points; ++i) {
+            index_t v = insert(
+                ExactPoint(vec2(points+2*sorted_indices[i])), 0, hint
+            );
+            if(indices != nullptr) {
+                indices[sorted_indices[i]] = v;
+            }
+            hint = vT(v);
+        }
+    }
+
     void ExactCDT2d::add_point(const ExactPoint& p, index_t id) {
         point_.push_back(p);
         id_.push_back(id);
@@ -34354,7 +35005,7 @@ namespace GEO {
 
     void ExactCDT2d::commit_insert_transaction() {
         for(const auto& it: pred_cache_insert_buffer_) {
-            pred_cache_[it.first] = it.second;
+            pred_cache_.insert(it.first, it.second);
         }
         pred_cache_insert_buffer_.resize(0);
         use_pred_cache_insert_buffer_ = false;
@@ -34386,33 +35037,26 @@ namespace GEO {
     Sign ExactCDT2d::orient2d(index_t i, index_t j, index_t k) const {
         trindex K(i, j, k);
 
-        if(use_pred_cache_insert_buffer_) {
-            Sign result = PCK::orient_2d(
-                point_[K.indices[0]],
-                point_[K.indices[1]],
-                point_[K.indices[2]]
-            );
-            pred_cache_insert_buffer_.push_back(std::make_pair(K, result));
-            if(odd_order(i,j,k)) {
-                result = Sign(-result);
-            }
-            return result;
-        }
-        
-        bool inserted;
-        std::map<trindex, Sign>::iterator it;
-        std::tie(it,inserted) = pred_cache_.insert(std::make_pair(K,ZERO));
+        // Predicates are looked up also during an insertion transaction:
+        // the cache never contains the vertex being inserted (that may
+        // be discarded if it is a duplicate), only the new results are
+        // buffered.
         Sign result;
-        
-        if(inserted) {
+        if(!pred_cache_.enabled() || !pred_cache_.find(K, result)) {
             result = PCK::orient_2d(
                 point_[K.indices[0]],
                 point_[K.indices[1]],
                 point_[K.indices[2]]
             );
-            it->second = result;
-        } else {
-            result = it->second;
+            if(use_pred_cache_insert_buffer_) {
+                if(pred_cache_.enabled()) {
+                    pred_cache_insert_buffer_.push_back(
+                        std::make_pair(K, result)
+                    );
+                }
+            } else {
+                pred_cache_.insert(K, result);
+            }
         }
 
         if(odd_order(i,j,k)) {
@@ -34452,6 +35096,10 @@ namespace GEO {
         j = constraints_[E1].indices[1];
         k = constraints_[E2].indices[0];
         l = constraints_[E2].indices[1];
+
+        // The intersection and the temporaries are allocated
+        // from the pool of this triangulation.
+        ExpansionPool::Scope expansion_scope(expansion_pool_);
         
         exact::vec2h U = point_[j] - point_[i];
         exact::vec2h V = point_[l] - point_[k];
@@ -2645,6 +2645,11 @@ namespace GEO {
 #define GEOGRAM_BASIC_PROCESS
 
 #include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
 
 
 namespace GEO {
@@ -2724,6 +2729,13 @@ namespace GEO {
 
         virtual index_t maximum_concurrent_threads() = 0;
 
+        /**
+         * \brief Tests whether run_threads() can be called from
+         *  a thread that is run by this ThreadManager.
+         * \details If not, nested parallel regions are run sequentially.
+         */
+        virtual bool supports_nested_threads() const;
+
         virtual void enter_critical_section() = 0;
 
         virtual void leave_critical_section() = 0;
@@ -2766,6 +2778,87 @@ namespace GEO {
         ) override;
     };
 
+    /**
+     * \brief A ThreadManager with a persistent pool of worker threads.
+     * \details The worker threads are created once, in the constructor.
+     *  Each worker has its own deque of tasks. It pops tasks from the
+     *  back of its deque, and when it is empty, it steals tasks from the
+     *  front of the deques of the other workers. A thread that calls
+     *  run_threads() executes tasks while waiting for its own ones, hence
+     *  parallel regions can be nested. Install it with
+     *  Process::set_thread_manager(new WorkStealingThreadManager).
+     */
+    class GEOGRAM_API WorkStealingThreadManager : public ThreadManager {
+    public:
+        /**
+         * \brief WorkStealingThreadManager constructor
+         * \param[in] nb_threads total number of threads, including the
+         *  thread that calls run_threads(), or 0 to use all the cores
+         */
+        WorkStealingThreadManager(index_t nb_threads = 0);
+
+        index_t maximum_concurrent_threads() override;
+
+        bool supports_nested_threads() const override;
+
+        void enter_critical_section() override;
+
+        void leave_critical_section() override;
+
+        /**
+         * \brief Gets the number of tasks that were stolen from the
+         *  deque of another thread since construction.
+         */
+        Numeric::uint64 nb_steals() const {
+            return nb_steals_;
+        }
+
+    protected:
+        ~WorkStealingThreadManager() override;
+
+        void run_concurrent_threads(
+            ThreadGroup& threads, index_t max_threads
+        ) override;
+
+        struct Task {
+            Thread* thread;
+            std::atomic<index_t>* pending;
+        };
+
+        struct TaskDeque {
+            std::mutex lock;
+            std::deque<Task> tasks;
+        };
+
+        /**
+         * \brief Gets a task, first from the back of deque \p q, then
+         *  from the front of the other deques.
+         * \retval true if a task was found
+         */
+        bool get_task(index_t q, Task& task);
+
+        void run_task(const Task& task);
+
+        void worker(index_t q);
+
+        /**
+         * \brief Gets the deque used by the calling thread.
+         * \details Worker threads use their own deque, all the other
+         *  threads share the last one.
+         */
+        index_t current_deque() const;
+
+    private:
+        std::vector<std::thread> workers_;
+        std::vector<TaskDeque> deques_;
+        std::atomic<index_t> nb_queued_;
+        std::atomic<Numeric::uint64> nb_steals_;
+        std::mutex idle_lock_;
+        std::condition_variable idle_;
+        bool stop_;
+        std::mutex critical_section_;
+    };
+
     namespace Process {
 
         void GEOGRAM_API initialize(int flags);
@@ -2793,6 +2886,8 @@ namespace GEO {
 
         bool GEOGRAM_API is_running_threads();
 
+        bool GEOGRAM_API supports_nested_threads();
+
         void GEOGRAM_API enable_FPE(bool flag);
 
         bool GEOGRAM_API FPE_enabled();
@@ -5664,47 +5759,93 @@ namespace GEO {
     namespace PCK {
 
         
-#ifdef PCK_STATS
+        // Counters of a predicate. They are disabled by default (unless
+        // compiled with PCK_STATS) and can be enabled at runtime with
+        // set_enabled(). Each thread increments its own counters, that
+        // are merged by count().
         class GEOGRAM_API PredicateStats {
         public:
+            enum Counter {
+                INVOKE, FILTER_FAILURE, EXACT, SOS, NB_COUNTERS
+            };
+
             PredicateStats(const char* name);
+
             void log_invoke() {
-                ++invoke_count_;
+                log(INVOKE);
+            }
+
+            // Only logged by the predicates that have a filter,
+            // when it cannot determine the sign.
+            void log_filter_failure() {
+                log(FILTER_FAILURE);
             }
+
             void log_exact() {
-                ++exact_count_;
+                log(EXACT);
             }
+
             void log_SOS() {
-                ++SOS_count_;
+                log(SOS);
+            }
+
+            const char* name() const {
+                return name_;
             }
+
+            Numeric::uint64 count(Counter c) const;
+
             void show_stats();
+
             static void show_all_stats();
-        private:
-            static PredicateStats* first_;
-            PredicateStats* next_;
-            const char* name_;
-            std::atomic<Numeric::int64> invoke_count_;
-            std::atomic<Numeric::int64> exact_count_;
-            std::atomic<Numeric::int64> SOS_count_;
-        };
-#else
-        class PredicateStats {
-        public:
-            PredicateStats(const char* name) {
-                geo_argused(name);
+
+            static void set_enabled(bool x) {
+                enabled_ = x;
             }
-            void log_invoke() {
+
+            static bool enabled() {
+                return enabled_;
             }
-            void log_exact() {
+
+            // Resets the counters of all the predicates.
+            static void reset_all();
+
+            // Iteration over all the predicates.
+            static PredicateStats* first() {
+                return first_;
             }
-            void log_SOS() {
+
+            PredicateStats* next() const {
+                return next_;
             }
-            static void show_all_stats() {
-                Logger::out("Stats") << "Compiled without PCK_STAT (no stats)"
-                                     << std::endl;
+
+            static const index_t MAX_PREDICATES = 64;
+
+        private:
+            void log(Counter c) {
+                if(enabled_) {
+                    std::atomic<Numeric::uint64>& n =
+                        thread_counter(id_, c);
+                    // Only the current thread writes this counter.
+                    n.store(
+                        n.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed
+                    );
+                }
             }
+
+            static std::atomic<Numeric::uint64>& thread_counter(
+                index_t id, Counter c
+            );
+
+            static bool enabled_;
+            static PredicateStats* first_;
+            static index_t nb_;
+            PredicateStats* next_;
+            const char* name_;
+            index_t id_;
         };
-#endif
+
 
         
 #define SOS_result(x) [&]()->Sign { return Sign(x); }
@@ -6085,6 +6226,79 @@ namespace GEO {
 
     
 
+    // Size-class pool for the storage of the expansions allocated on
+    // the heap. While a pool is current (see Scope), the expansions
+    // created by the calling thread are allocated from it, without
+    // locking. Each expansion remembers its pool, so that it can be
+    // deleted at any time, from any scope. Storage is released in bulk
+    // by clear().
+    class GEOGRAM_API ExpansionPool {
+    public:
+        ExpansionPool();
+
+        ~ExpansionPool();
+
+        void* malloc(size_t size);
+
+        void free(void* ptr, size_t size);
+
+        // Releases all the chunks if no allocated item is alive
+        // (statistics are kept).
+        void clear();
+
+        index_t nb_live() const {
+            return nb_live_;
+        }
+
+        // Number of allocations and allocated bytes since the
+        // last call to reset_stats().
+        Numeric::uint64 nb_allocations() const {
+            return nb_allocations_;
+        }
+
+        Numeric::uint64 nb_bytes() const {
+            return nb_bytes_;
+        }
+
+        // Bytes in the chunks owned by this pool.
+        size_t reserved_bytes() const {
+            return reserved_bytes_;
+        }
+
+        void reset_stats() {
+            nb_allocations_ = 0;
+            nb_bytes_ = 0;
+        }
+
+        static ExpansionPool* current();
+
+        // Makes a pool current for the calling thread during
+        // the lifetime of the Scope.
+        class Scope {
+        public:
+            Scope(ExpansionPool& pool);
+            ~Scope();
+        private:
+            ExpansionPool* prev_;
+        };
+
+    private:
+        ExpansionPool(const ExpansionPool&) = delete;
+        ExpansionPool& operator=(const ExpansionPool&) = delete;
+
+        static const index_t MAX_ITEM_SIZE = 1024;
+        static const index_t NB_ITEMS_PER_CHUNK = 64;
+
+        void new_chunk(size_t item_size);
+
+        std::vector<Memory::pointer> free_list_;
+        std::vector<Memory::pointer> chunks_;
+        index_t nb_live_;
+        Numeric::uint64 nb_allocations_;
+        Numeric::uint64 nb_bytes_;
+        size_t reserved_bytes_;
+    };
+
     class GEOGRAM_API expansion {
     public:
         index_t length() const {
@@ -11070,6 +11284,12 @@ namespace GEO {
         
         void insert_constraint(index_t i, index_t j);
 
+        // Inserts constraints (vertices[2*c], vertices[2*c+1]) and restores
+        // the Delaunay condition once for all of them.
+        void insert_constraints(
+            index_t nb_constraints, const index_t* vertices
+        );
+
         void remove_external_triangles(
             bool remove_internal_holes=false
         );
@@ -11079,7 +11299,11 @@ namespace GEO {
         }
         
         index_t nT() const {
+#ifdef CDT_PACKED_TRIANGLES
+            return T_.size();
+#else
             return T_.size()/3;
+#endif
         }
 
         index_t nv() const {
@@ -11089,29 +11313,66 @@ namespace GEO {
         index_t ncnstr() const {
             return ncnstr_;
         }
+
+        Numeric::uint64 nb_locate() const {
+            return nb_locate_;
+        }
+
+        Numeric::uint64 nb_locate_traversed_T() const {
+            return nb_locate_traversed_T_;
+        }
+
+        void reset_locate_stats() {
+            nb_locate_ = 0;
+            nb_locate_traversed_T_ = 0;
+        }
+
+        Numeric::uint64 nb_swaps() const {
+            return nb_swaps_;
+        }
+
+        void reset_swap_stats() {
+            nb_swaps_ = 0;
+        }
         
         index_t Tv(index_t t, index_t lv) const {
             geo_debug_assert(t<nT());
             geo_debug_assert(lv<3);
+#ifdef CDT_PACKED_TRIANGLES
+            return from_Tindex(T_[t].v[lv]);
+#else
             return T_[3*t+lv];
+#endif
         }
 
         index_t Tv_find(index_t t, index_t v) const {
             geo_debug_assert(t<nT());
             geo_debug_assert(v<nv());
+#ifdef CDT_PACKED_TRIANGLES
+            return find_3(T_[t].v, v);
+#else
             return find_3(T_.data()+3*t, v); 
+#endif
         }
         
         index_t Tadj(index_t t, index_t le) const {
             geo_debug_assert(t<nT());
             geo_debug_assert(le<3);
+#ifdef CDT_PACKED_TRIANGLES
+            return from_Tindex(T_[t].adj[le]);
+#else
             return Tadj_[3*t+le];
+#endif
         }
         
         index_t Tadj_find(index_t t1, index_t t2) const {
             geo_debug_assert(t1<nT());
             geo_debug_assert(t2<nT());
+#ifdef CDT_PACKED_TRIANGLES
+            return find_3(T_[t1].adj, t2);
+#else
             return find_3(Tadj_.data()+3*t1, t2); 
+#endif
         }
 
         index_t vT(index_t v) const {
@@ -11123,7 +11384,11 @@ namespace GEO {
         index_t Tedge_cnstr_first(index_t t, index_t le) const {
             geo_debug_assert(t < nT());
             geo_debug_assert(le < 3);
+#ifdef CDT_PACKED_TRIANGLES
+            return from_Tindex(T_[t].ecnstr_first[le]);
+#else
             return Tecnstr_first_[3*t+le];
+#endif
         }
 
         index_t edge_cnstr_next(index_t ecit) const {
@@ -11167,20 +11432,38 @@ namespace GEO {
         void Tset_flag(index_t t, index_t flag) {
             geo_debug_assert(t < nT());
             geo_debug_assert(flag < 8);
-            Tflags_[t] |= Numeric::uint8(1u << flag);
+            Tflags(t) |= Numeric::uint8(1u << flag);
         }
 
         void Treset_flag(index_t t, index_t flag) {
             geo_debug_assert(t < nT());
             geo_debug_assert(flag < 8);
-            Tflags_[t] &= Numeric::uint8(~(1u << flag));
+            Tflags(t) &= Numeric::uint8(~(1u << flag));
         }
 
         bool Tflag_is_set(index_t t, index_t flag) {
             geo_debug_assert(t < nT());
             geo_debug_assert(flag < 8);
-            return ((Tflags_[t] & (1u << flag)) != 0);
+            return ((Tflags(t) & (1u << flag)) != 0);
+        }
+
+#ifdef CDT_PACKED_TRIANGLES
+        Numeric::uint8& Tflags(index_t t) {
+            return T_[t].flags;
+        }
+
+        Numeric::uint8 Tflags(index_t t) const {
+            return T_[t].flags;
+        }
+#else
+        Numeric::uint8& Tflags(index_t t) {
+            return Tflags_[t];
+        }
+
+        Numeric::uint8 Tflags(index_t t) const {
+            return Tflags_[t];
         }
+#endif
 
         enum {
             DLIST_S_ID=0,
@@ -11191,12 +11474,13 @@ namespace GEO {
 
         enum {
             T_MARKED_FLAG  = DLIST_NB,  
-            T_VISITED_FLAG = DLIST_NB+1 
+            T_VISITED_FLAG = DLIST_NB+1,
+            T_TOUCHED_FLAG = DLIST_NB+2
         };
 
         bool Tis_in_list(index_t t) const {
             return (
-                (Tflags_[t] &
+                (Tflags(t) &
                  Numeric::uint8((1 << DLIST_NB)-1)
                 ) != 0
             );
@@ -11442,6 +11726,18 @@ namespace GEO {
             geo_debug_assert(adj2 != adj3 || adj2 == index_t(-1));
             geo_debug_assert(adj3 != adj1 || adj3 == index_t(-1));
             geo_debug_assert(orient2d(v1,v2,v3) != ZERO);
+#ifdef CDT_PACKED_TRIANGLES
+            Triangle& T = T_[t];
+            T.v[0] = to_Tindex(v1);
+            T.v[1] = to_Tindex(v2);
+            T.v[2] = to_Tindex(v3);
+            T.adj[0] = to_Tindex(adj1);
+            T.adj[1] = to_Tindex(adj2);
+            T.adj[2] = to_Tindex(adj3);
+            T.ecnstr_first[0] = to_Tindex(e1cnstr);
+            T.ecnstr_first[1] = to_Tindex(e2cnstr);
+            T.ecnstr_first[2] = to_Tindex(e3cnstr);
+#else
             T_[3*t  ]    = v1;
             T_[3*t+1]    = v2;
             T_[3*t+2]    = v3;                        
@@ -11451,15 +11747,32 @@ namespace GEO {
             Tecnstr_first_[3*t]   = e1cnstr;
             Tecnstr_first_[3*t+1] = e2cnstr;
             Tecnstr_first_[3*t+2] = e3cnstr;
+#endif
             v2T_[v1] = t;
             v2T_[v2] = t;
             v2T_[v3] = t;
+            if(defer_Delaunay_) {
+                Tset_flag(t, T_TOUCHED_FLAG);
+            }
         }
 
         void Trot(index_t t, index_t lv) {
             geo_debug_assert(t < nT());
             geo_debug_assert(lv < 3);
             if(lv != 0) {
+#ifdef CDT_PACKED_TRIANGLES
+                index_t i = lv;
+                index_t j = (lv+1)%3;
+                index_t k = (lv+2)%3;
+                Tset(
+                    t,
+                    Tv(t,i), Tv(t,j), Tv(t,k),
+                    Tadj(t,i), Tadj(t,j), Tadj(t,k),
+                    Tedge_cnstr_first(t,i),
+                    Tedge_cnstr_first(t,j),
+                    Tedge_cnstr_first(t,k)
+                );
+#else
                 index_t i = 3*t+lv;
                 index_t j = 3*t+((lv+1)%3);
                 index_t k = 3*t+((lv+2)%3);
@@ -11469,6 +11782,7 @@ namespace GEO {
                     Tadj_[i], Tadj_[j], Tadj_[k],
                     Tecnstr_first_[i], Tecnstr_first_[j], Tecnstr_first_[k]
                 );
+#endif
             }
         }
 
@@ -11478,7 +11792,11 @@ namespace GEO {
             geo_debug_assert(t < nT());
             geo_debug_assert(adj < nT());
             geo_debug_assert(le < 3);
+#ifdef CDT_PACKED_TRIANGLES
+            T_[t].adj[le] = to_Tindex(adj);
+#else
             Tadj_[3*t+le] = adj;
+#endif
         }
 
         index_t Topp(index_t t, index_t e=0) const {
@@ -11506,11 +11824,26 @@ namespace GEO {
         
         index_t Tnew() {
             index_t t = nT();
+#ifdef CDT_PACKED_TRIANGLES
+            // Indices (triangles, vertices, constraint lists) must be
+            // representable in a Tindex (-1 is reserved)
+            geo_assert(t+1 < index_t(Tindex(-1)));
+            geo_assert(nv() < index_t(Tindex(-1)));
+            Triangle T;
+            for(index_t i=0; i<3; ++i) {
+                T.v[i] = Tindex(-1);
+                T.adj[i] = Tindex(-1);
+                T.ecnstr_first[i] = Tindex(-1);
+            }
+            T.flags = 0;
+            T_.push_back(T);
+#else
             index_t nc = (t+1)*3; // new number of corners
             T_.resize(nc, index_t(-1));
             Tadj_.resize(nc, index_t(-1));
             Tecnstr_first_.resize(nc, index_t(-1));
             Tflags_.resize(t+1,0);
+#endif
             Tnext_.resize(t+1,index_t(-1));
             Tprev_.resize(t+1,index_t(-1));
             return t;
@@ -11521,7 +11854,11 @@ namespace GEO {
         ) {
             geo_debug_assert(t < nT());
             geo_debug_assert(le < 3);
+#ifdef CDT_PACKED_TRIANGLES
+            T_[t].ecnstr_first[le] = to_Tindex(ecit);
+#else
             Tecnstr_first_[3*t+le] = ecit;
+#endif
         }
 
         void Tadd_edge_cnstr(
@@ -11545,6 +11882,9 @@ namespace GEO {
                     return;
                 }
             }
+#ifdef CDT_PACKED_TRIANGLES
+            geo_assert(ecnstr_val_.size()+1 < index_t(Tindex(-1)));
+#endif
             ecnstr_val_.push_back(cnstr_id);
             ecnstr_next_.push_back(Tedge_cnstr_first(t,le));
             Tset_edge_cnstr_first(t,le, ecnstr_val_.size()-1); 
@@ -11752,6 +12092,27 @@ namespace GEO {
             return result;
         }
 
+        index_t find_edge(index_t v1, index_t v2) {
+            index_t result = index_t(-1);
+            for_each_T_around_v(
+                v1, [&](index_t t, index_t lv)->bool {
+                    if(Tv(t, (lv+1)%3) == v2) {
+                        Trot(t, (lv+2)%3);
+                        result = t;
+                        return true;
+                    } else if(Tv(t, (lv+2)%3) == v2) {
+                        Trot(t, (lv+1)%3);
+                        result = t;
+                        return true;
+                    }
+                    return false;
+                }
+            );
+            return result;
+        }
+
+        void Delaunayize_touched_triangles();
+        
         index_t locate_naive(
             index_t v, index_t hint = index_t(-1), Sign* orient = nullptr
         ) const;
@@ -11763,13 +12124,53 @@ namespace GEO {
         void Delaunayize_new_edges_naive(vector<Edge>& N);
 
     protected:
+#ifdef CDT_PACKED_TRIANGLES
+        // Packed storage: vertices, adjacent triangles, constraint lists
+        // and flags of a triangle in a single record, with small indices
+        // (define CDT_PACKED_INDEX as Numeric::uint32 for triangulations
+        // with more than 65534 triangles, vertices or edge constraints).
+#ifndef CDT_PACKED_INDEX
+#define CDT_PACKED_INDEX Numeric::uint16
+#endif
+        typedef CDT_PACKED_INDEX Tindex;
+
+        struct Triangle {
+            Tindex v[3];
+            Tindex adj[3];
+            Tindex ecnstr_first[3];
+            Numeric::uint8 flags;
+        };
+
+        static index_t from_Tindex(Tindex x) {
+            return (x == Tindex(-1)) ? index_t(-1) : index_t(x);
+        }
+
+        static Tindex to_Tindex(index_t x) {
+            geo_debug_assert(x == index_t(-1) || x < index_t(Tindex(-1)));
+            return Tindex(x);
+        }
+
+        static inline index_t find_3(const Tindex* T, index_t v) {
+            // Same as find_3() above
+            Tindex tv = to_Tindex(v);
+            index_t result = index_t( (T[1] == tv) | ((T[2] == tv) * 2) );
+            geo_debug_assert(T[result] == tv);
+            return result; 
+        }
+#endif
+        
         index_t nv_;
         index_t ncnstr_;
+#ifdef CDT_PACKED_TRIANGLES
+        vector<Triangle> T_;
+        vector<index_t> v2T_;      
+#else
         vector<index_t> T_;        
         vector<index_t> Tadj_;     
         vector<index_t> v2T_;      
         vector<uint8_t> Tflags_;   
         vector<index_t> Tecnstr_first_;  
+#endif
         vector<index_t> ecnstr_val_;     
         vector<index_t> ecnstr_next_;    
         vector<index_t> Tnext_;    
@@ -11778,6 +12179,10 @@ namespace GEO {
         Sign orient_012_;          
         bool exact_incircle_;      
         bool exact_intersections_; 
+        mutable Numeric::uint64 nb_locate_;
+        mutable Numeric::uint64 nb_locate_traversed_T_;
+        Numeric::uint64 nb_swaps_;
+        bool defer_Delaunay_;
     };
 
     
@@ -11853,6 +12258,104 @@ namespace GEO {
 
     
 
+    // Cache for orientation predicates, open-addressing hash table
+    // keyed on sorted triplets of indices. Entries are timestamped,
+    // so that clear() does not need to traverse the table.
+    class GEOGRAM_API OrientCache {
+    public:
+        OrientCache();
+
+        void clear();
+
+        // Maximum number of entries, 0 to disable the cache. When the
+        // cache is full, it is cleared.
+        void set_max_size(index_t max_size);
+
+        index_t max_size() const {
+            return max_size_;
+        }
+
+        bool enabled() const {
+            return max_size_ != 0;
+        }
+
+        index_t size() const {
+            return size_;
+        }
+
+        bool find(const trindex& K, Sign& result) const {
+            ++nb_lookups_;
+            if(size_ == 0) {
+                return false;
+            }
+            for(index_t i = hash(K);; i = (i+1) & mask_) {
+                ++nb_probes_;
+                const Entry& E = entries_[i];
+                if(E.stamp != stamp_) {
+                    return false;
+                }
+                if(
+                    E.indices[0] == K.indices[0] &&
+                    E.indices[1] == K.indices[1] &&
+                    E.indices[2] == K.indices[2]
+                ) {
+                    ++nb_hits_;
+                    result = Sign(E.sign);
+                    return true;
+                }
+            }
+        }
+
+        void insert(const trindex& K, Sign value);
+
+        Numeric::uint64 nb_lookups() const {
+            return nb_lookups_;
+        }
+
+        Numeric::uint64 nb_hits() const {
+            return nb_hits_;
+        }
+
+        Numeric::uint64 nb_probes() const {
+            return nb_probes_;
+        }
+
+        void reset_stats() {
+            nb_lookups_ = 0;
+            nb_hits_ = 0;
+            nb_probes_ = 0;
+        }
+
+    protected:
+        struct Entry {
+            index_t indices[3];
+            Numeric::uint32 stamp;
+            Numeric::int32 sign;
+        };
+
+        index_t hash(const trindex& K) const {
+            Numeric::uint64 h =
+                Numeric::uint64(K.indices[0]) * 0x9E3779B97F4A7C15ull ^
+                Numeric::uint64(K.indices[1]) * 0xC2B2AE3D27D4EB4Full ^
+                Numeric::uint64(K.indices[2]) * 0x165667B19E3779F9ull;
+            return index_t(h ^ (h >> 32)) & mask_;
+        }
+
+        void insert_entry(const trindex& K, Numeric::int32 sign);
+
+        void grow();
+
+    private:
+        vector<Entry> entries_;
+        index_t mask_;
+        index_t size_;
+        index_t max_size_;
+        Numeric::uint32 stamp_;
+        mutable Numeric::uint64 nb_lookups_;
+        mutable Numeric::uint64 nb_hits_;
+        mutable Numeric::uint64 nb_probes_;
+    };
+
     class GEOGRAM_API ExactCDT2d : public CDTBase2d {
     public:
         typedef exact::vec2h ExactPoint;
@@ -11867,11 +12370,31 @@ namespace GEO {
             const ExactPoint& p, index_t id=0, index_t hint = index_t(-1)
         );
 
+        // Inserts points in Hilbert order, each point is located
+        // from the previous one. Duplicated points are merged, indices
+        // (if non-null) receives the vertex of each point.
+        void insert(
+            index_t nb_points, const double* points, index_t* indices = nullptr
+        );
+
         void insert_constraint(index_t v1, index_t v2, index_t operand_bits=0) {
             constraints_.push_back(bindex(v1,v2,bindex::KEEP_ORDER));
             cnstr_operand_bits_.push_back(operand_bits);
             CDTBase2d::insert_constraint(v1,v2);
         }
+
+        void insert_constraints(
+            index_t nb_constraints, const index_t* vertices,
+            index_t operand_bits=0
+        ) {
+            for(index_t c=0; c<nb_constraints; ++c) {
+                constraints_.push_back(
+                    bindex(vertices[2*c], vertices[2*c+1], bindex::KEEP_ORDER)
+                );
+                cnstr_operand_bits_.push_back(operand_bits);
+            }
+            CDTBase2d::insert_constraints(nb_constraints, vertices);
+        }
         
         void create_enclosing_quad(
             const ExactPoint& p1, const ExactPoint& p2,
@@ -11909,6 +12432,28 @@ namespace GEO {
         );
 
         void save(const std::string& filename) const override;
+
+        void set_pred_cache_max_size(index_t max_size) {
+            pred_cache_.set_max_size(max_size);
+        }
+
+        const OrientCache& pred_cache() const {
+            return pred_cache_;
+        }
+
+        OrientCache& pred_cache() {
+            return pred_cache_;
+        }
+
+        // Pool for the coordinates of the intersections, released
+        // in bulk by clear().
+        const ExpansionPool& expansion_pool() const {
+            return expansion_pool_;
+        }
+
+        ExpansionPool& expansion_pool() {
+            return expansion_pool_;
+        }
         
     protected:
         void add_point(const ExactPoint& p, index_t id = index_t(-1));
@@ -11926,6 +12471,8 @@ namespace GEO {
         ) override;
         
     protected:
+        // Declared before point_, so that it is destroyed after it.
+        ExpansionPool expansion_pool_;
         vector<ExactPoint> point_;
 #ifndef INTERSECTIONS_USE_EXACT_NT            
         vector<double> length_;
@@ -11933,7 +12480,7 @@ namespace GEO {
         vector<index_t> id_;
         vector<index_t> cnstr_operand_bits_;
         vector<index_t> facet_inclusion_bits_;
-        mutable std::map<trindex, Sign> pred_cache_;
+        mutable OrientCache pred_cache_;
         bool use_pred_cache_insert_buffer_;
         mutable std::vector<std::pair<trindex, Sign>> pred_cache_insert_buffer_;
         vector<bindex> constraints_;
@@ -0,0 +1,39 @@
+
+# Benchmark: compares integer predicates with exact predicates
+# usage: benchmark.sh inputdir [triangulate options]
+#  (inputdir contains the frameXXXX.fig files generated by vectorize.sh)
+# License: BSD 3 clauses
+
+if [ $# -lt 1 ]; then
+   echo "usage: $0 inputdir [triangulate options]"
+   exit 1
+fi
+
+INPUTDIR=$1
+shift
+TRIANGULATE=`dirname $0`/triangulate
+OUTDIR=`mktemp -d`
+
+# run name options...: runs triangulate and prints elapsed time
+run() {
+   NAME=$1
+   shift
+   START=`date +%s%N`
+   $TRIANGULATE $INPUTDIR $OUTDIR/$NAME.bin "$@" > /dev/null 2>&1
+   END=`date +%s%N`
+   echo "$NAME: $(( (END-START)/1000000 )) ms"
+}
+
+run exact grid_predicates=false "$@"
+run grid grid_predicates=true "$@"
+
+if cmp -s $OUTDIR/exact.bin $OUTDIR/grid.bin; then
+   echo "outputs are identical"
+   STATUS=0
+else
+   echo "outputs differ"
+   STATUS=1
+fi
+
+rm -rf $OUTDIR
+exit $STATUS
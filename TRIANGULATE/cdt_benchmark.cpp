@@ -0,0 +1,85 @@
+/*
+ * Microbenchmark for the triangle storage of CDTBase2d:
+ *  measures point insertion and point location in triangulations
+ *  of the size of a ST_NICCC frame (random points on a 256x256 grid).
+ * Compile with and without -DCDT_PACKED_TRIANGLES to compare
+ *  the two storage layouts (see cdt_benchmark.sh).
+ */
+
+#include "Delaunay_psm.h"
+#include <chrono>
+#include <iostream>
+#include <cstdlib>
+
+namespace {
+    using namespace GEO;
+
+    /**
+     * \brief A CDT2d that exposes locate()
+     */
+    class BenchmarkCDT2d : public CDT2d {
+    public:
+        using CDTBase2d::locate;
+    };
+
+    double elapsed_ns(
+        std::chrono::high_resolution_clock::time_point start,
+        std::chrono::high_resolution_clock::time_point end
+    ) {
+        return double(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                end-start
+            ).count()
+        );
+    }
+}
+
+int main(int argc, char** argv) {
+    GEO::initialize();
+
+    GEO::index_t nb_points = (argc > 1) ? GEO::index_t(atoi(argv[1])) : 250;
+    GEO::index_t nb_rounds = (argc > 2) ? GEO::index_t(atoi(argv[2])) : 2000;
+    GEO::index_t nb_locate = 10;
+
+    BenchmarkCDT2d cdt;
+    double insert_time = 0.0;
+    double locate_time = 0.0;
+    GEO::Numeric::uint64 nb_inserted = 0;
+    GEO::Numeric::uint64 nb_located = 0;
+    GEO::index_t check = 0;
+
+    GEO::Numeric::random_reset();
+    for(GEO::index_t r=0; r<nb_rounds; ++r) {
+        cdt.clear();
+        cdt.create_enclosing_rectangle(0.0, 0.0, 255.0, 255.0);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for(GEO::index_t i=0; i<nb_points; ++i) {
+            double x = double(GEO::Numeric::random_int32() & 255);
+            double y = double(GEO::Numeric::random_int32() & 255);
+            cdt.insert(GEO::vec2(x,y));
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        insert_time += elapsed_ns(start, end);
+        nb_inserted += nb_points;
+
+        start = std::chrono::high_resolution_clock::now();
+        for(GEO::index_t k=0; k<nb_locate; ++k) {
+            for(GEO::index_t v=0; v<cdt.nv(); ++v) {
+                check += cdt.locate(v);
+            }
+        }
+        end = std::chrono::high_resolution_clock::now();
+        locate_time += elapsed_ns(start, end);
+        nb_located += GEO::Numeric::uint64(nb_locate) * cdt.nv();
+    }
+
+    std::cout << "insert: "
+              << insert_time / double(nb_inserted) << " ns/point, "
+              << "locate: "
+              << locate_time / double(nb_located) << " ns/point "
+              << "(" << nb_rounds << " triangulations of "
+              << nb_points << " points, check=" << check << ")"
+              << std::endl;
+    return 0;
+}
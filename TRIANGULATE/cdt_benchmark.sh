@@ -0,0 +1,21 @@
+
+# Microbenchmark: compares the default and packed triangle storages
+# usage: cdt_benchmark.sh [nb_points] [nb_rounds]
+# License: BSD 3 clauses
+
+cd `dirname $0`
+
+CXXFLAGS="-Wall -Wpedantic -O3 -DNDEBUG -I../"
+OUTDIR=`mktemp -d`
+
+g++ $CXXFLAGS cdt_benchmark.cpp Delaunay_psm.cpp -lm \
+    -o $OUTDIR/cdt_benchmark || exit 1
+g++ $CXXFLAGS -DCDT_PACKED_TRIANGLES cdt_benchmark.cpp Delaunay_psm.cpp -lm \
+    -o $OUTDIR/cdt_benchmark_packed || exit 1
+
+echo -n "default: "
+$OUTDIR/cdt_benchmark "$@"
+echo -n "packed:  "
+$OUTDIR/cdt_benchmark_packed "$@"
+
+rm -rf $OUTDIR
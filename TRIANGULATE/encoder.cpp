@@ -0,0 +1,1245 @@
+#include "encoder.h"
+
+std::string to_string(int i, int len) {
+    std::ostringstream out; 
+    out << i;
+    std::string result = out.str();
+    while(int(result.length()) < len) {
+        result = "0" + result;
+    }
+    return result;
+}
+
+
+void triangulate_polylines(
+    GEO::Triangulation& triangulation, GEO::PolylinesSimplifier& polylines
+) {
+    triangulation.clear();
+    triangulation.create_enclosing_rectangle(0,0,255,255);
+    triangulation.insert_polylines(polylines);
+
+    if(
+        triangulation.nv() > 255 &&
+        GEO::CmdLine::get_arg_bool("simplify")
+    ) {
+        GEO::index_t nv_orig = triangulation.nv();
+        double max_error = GEO::CmdLine::get_arg_double(
+            "simplify_max_error"
+        );
+        // Vertices that are not points of the polylines (corners
+        // of the enclosing rectangle, intersections) are removed from
+        // the budget. Since the intersections can change, we may need
+        // to retry with a smaller budget.
+        GEO::index_t budget = 255;
+        for(int iter=0; iter<10 && triangulation.nv() > 255; ++iter) {
+            GEO::index_t nb_points = polylines.nb_distinct_points();
+            GEO::index_t excess = triangulation.nv() - 255;
+            budget = std::min(
+                budget, nb_points - std::min(nb_points, excess)
+            );
+            bool budget_met = polylines.simplify(budget, max_error);
+            triangulation.clear();
+            triangulation.create_enclosing_rectangle(0,0,255,255);
+            triangulation.insert_polylines(polylines);
+            if(!budget_met) {
+                break;
+            }
+        }
+        std::cerr << "Simplified: " << nv_orig << " -> "
+                  << triangulation.nv() << " vertices, error: "
+                  << polylines.error() << std::endl;
+    }
+    triangulation.classify();
+}
+
+bool update_triangulation(
+    GEO::Triangulation& triangulation,
+    const GEO::PolylinesSimplifier& polylines
+) {
+    if(triangulation.nT() == 0 || triangulation.needs_rebuild()) {
+        return false;
+    }
+    GEO::index_t nv_before = triangulation.nb_alive_vertices();
+    GEO::index_t ncnstr_before = triangulation.ncnstr();
+    if(!triangulation.update_polylines(polylines)) {
+        GEO::Logger::warn("Triangulation")
+            << "Incremental update failed, rebuilding" << std::endl;
+        return false;
+    }
+    GEO::index_t nv_after = triangulation.nb_alive_vertices();
+    if(nv_after > 255) {
+        return false;
+    }
+    std::cerr << "Incremental: " << nv_before << " -> " << nv_after
+              << " vertices, "
+              << triangulation.ncnstr() - ncnstr_before
+              << " new constraints" << std::endl;
+    triangulation.classify();
+    return true;
+}
+
+void polygonize(
+    GEO::Triangulation& triangulation,
+    std::vector<GEO::ConvexPolygon>& polygons
+) {
+    GEO::StageProfiler::Timer timer(GEO::StageProfiler::POLYGONIZE);
+    if(GEO::CmdLine::get_arg("polygonize") == "optimized") {
+        triangulation.get_convex_polygons_optimized(polygons);
+        if(GEO::CmdLine::get_arg_bool("polygonize_stats")) {
+            // The greedy partition is only computed for the comparison
+            std::vector<GEO::ConvexPolygon> greedy_polygons;
+            triangulation.get_convex_polygons_greedy(greedy_polygons);
+            std::cerr << "Polygons: " << polygons.size()
+                      << " (greedy: " << greedy_polygons.size();
+            if(greedy_polygons.size() != 0) {
+                std::cerr << ", "
+                          << 100.0 * (1.0 - double(polygons.size()) /
+                                      double(greedy_polygons.size()))
+                          << "% less";
+            }
+            std::cerr << ")" << std::endl;
+        }
+    } else {
+        triangulation.get_convex_polygons_greedy(polygons);
+    }
+}
+
+/**
+ * \brief Sorts polygons along a space-filling curve
+ * \details The polygons of a frame do not overlap, so that any order
+ *  gives the same image. A spatial order makes consecutive polygons
+ *  close to each other, which improves the locality of rasterization and
+ *  makes the encoded frame compress better.
+ * \param[in] triangulation the triangulation
+ * \param[in,out] polygons the convex polygons
+ * \param[in] order one of triangles (unchanged), morton, hilbert (code
+ *  of the center of the polygon on the curve), scanline (topmost then
+ *  leftmost vertex)
+ */
+void sort_polygons(
+    const GEO::Triangulation& triangulation,
+    std::vector<GEO::ConvexPolygon>& polygons,
+    const std::string& order
+) {
+    if(order == "triangles") {
+        return;
+    }
+    std::vector<std::pair<GEO::index_t, GEO::index_t> > keys;
+    for(GEO::index_t p=0; p<polygons.size(); ++p) {
+        const std::vector<GEO::index_t>& V = polygons[p].vertices;
+        GEO::index_t code = 0;
+        if(order == "scanline") {
+            int xmin = 255;
+            int ymin = 255;
+            for(GEO::index_t v: V) {
+                int x = triangulation.get_x(v);
+                int y = triangulation.get_y(v);
+                if(y < ymin || (y == ymin && x < xmin)) {
+                    xmin = x;
+                    ymin = y;
+                }
+            }
+            code = (GEO::index_t(ymin) << 8) | GEO::index_t(xmin);
+        } else {
+            int x = 0;
+            int y = 0;
+            for(GEO::index_t v: V) {
+                x += triangulation.get_x(v);
+                y += triangulation.get_y(v);
+            }
+            x /= int(V.size());
+            y /= int(V.size());
+            if(order == "hilbert") {
+                // Rotates the quadrants at each level (see Wikipedia,
+                // "Hilbert curve", xy2d)
+                for(int s=128; s>0; s/=2) {
+                    int rx = (x & s) != 0;
+                    int ry = (y & s) != 0;
+                    code += GEO::index_t(s * s * ((3 * rx) ^ ry));
+                    if(ry == 0) {
+                        if(rx == 1) {
+                            x = 255 - x;
+                            y = 255 - y;
+                        }
+                        std::swap(x,y);
+                    }
+                }
+            } else {
+                for(GEO::index_t bit=0; bit<8; ++bit) {
+                    code |= GEO::index_t((x >> bit) & 1) << (2*bit);
+                    code |= GEO::index_t((y >> bit) & 1) << (2*bit+1);
+                }
+            }
+        }
+        keys.push_back(std::make_pair(code, p));
+    }
+    std::stable_sort(keys.begin(), keys.end());
+    std::vector<GEO::ConvexPolygon> sorted(polygons.size());
+    for(GEO::index_t i=0; i<keys.size(); ++i) {
+        sorted[i].color = polygons[keys[i].second].color;
+        sorted[i].vertices.swap(polygons[keys[i].second].vertices);
+    }
+    polygons.swap(sorted);
+}
+
+/**
+ * \brief Orders the polygons in strips, where each polygon shares an
+ *  edge with the previous one, so that the shared vertices are not sent
+ *  again (see STRIP_LAST_EDGE in ST_NICCC/io.h).
+ * \details Strips are grown greedily. The neighbors of a polygon are the
+ *  polygons with the same edge in reverse order. A strip continues
+ *  through one of the two edges adjacent to the edge shared with the
+ *  previous polygon, alternating sides like a triangle strip.
+ * \param[in] polygons the convex polygons
+ * \param[in] background the color of the polygons that are skipped, or -1
+ * \param[out] strips the polygons in strip order, the vertices of a
+ *  strip piece start with the edge shared with the previous polygon
+ * \param[out] strip_edge for each polygon in \p strips, 0 if it starts a
+ *  strip, else STRIP_LAST_EDGE or STRIP_SECOND_EDGE
+ */
+void build_strips(
+    const std::vector<GEO::ConvexPolygon>& polygons, int background,
+    std::vector<GEO::ConvexPolygon>& strips,
+    std::vector<uint8_t>& strip_edge
+) {
+    typedef std::pair<GEO::index_t, GEO::index_t> Edge;
+    std::map<Edge, GEO::index_t> edge_polygon;
+    for(GEO::index_t p=0; p<polygons.size(); ++p) {
+        const std::vector<GEO::index_t>& V = polygons[p].vertices;
+        for(GEO::index_t i=0; i<V.size(); ++i) {
+            edge_polygon[Edge(V[i], V[(i+1)%V.size()])] = p;
+        }
+    }
+
+    std::vector<bool> done(polygons.size(), false);
+    // Gets the polygon on the other side of edge (v1,v2) that can
+    // continue a strip of the given color, or -1
+    auto neighbor = [&](GEO::index_t v1, GEO::index_t v2, int color) {
+        auto it = edge_polygon.find(Edge(v2,v1));
+        if(
+            it == edge_polygon.end() || done[it->second] ||
+            polygons[it->second].color != color
+        ) {
+            return GEO::index_t(-1);
+        }
+        return it->second;
+    };
+
+    strips.resize(0);
+    strip_edge.resize(0);
+    for(GEO::index_t p=0; p<polygons.size(); ++p) {
+        if(done[p] || polygons[p].color == background) {
+            continue;
+        }
+        int color = polygons[p].color;
+        
+        // First polygon of the strip: rotate it so that its last edge
+        // is shared with a neighbor, if there is one.
+        const std::vector<GEO::index_t>& V = polygons[p].vertices;
+        GEO::index_t n = GEO::index_t(V.size());
+        GEO::index_t start = 0;
+        for(GEO::index_t i=0; i<n; ++i) {
+            if(neighbor(V[i], V[(i+1)%n], color) != GEO::index_t(-1)) {
+                start = (i+1)%n;
+                break;
+            }
+        }
+        done[p] = true;
+        strips.push_back(polygons[p]);
+        std::rotate(
+            strips.back().vertices.begin(),
+            strips.back().vertices.begin() + std::ptrdiff_t(start),
+            strips.back().vertices.end()
+        );
+        strip_edge.push_back(0);
+
+        for(;;) {
+            const std::vector<GEO::index_t> W = strips.back().vertices;
+            GEO::index_t v1 = W[W.size()-1];
+            GEO::index_t v2 = W[0];
+            uint8_t edge = STRIP_LAST_EDGE;
+            GEO::index_t q = neighbor(v1, v2, color);
+            if(q == GEO::index_t(-1)) {
+                v1 = W[1];
+                v2 = W[2];
+                edge = STRIP_SECOND_EDGE;
+                q = neighbor(v1, v2, color);
+            }
+            if(q == GEO::index_t(-1)) {
+                break;
+            }
+            // Rotate the neighbor so that it starts with (v2,v1)
+            done[q] = true;
+            strips.push_back(polygons[q]);
+            std::vector<GEO::index_t>& Q = strips.back().vertices;
+            std::rotate(Q.begin(), std::find(Q.begin(), Q.end(), v2), Q.end());
+            geo_debug_assert(Q[1] == v1);
+            strip_edge.push_back(edge);
+        }
+    }
+}
+
+/**
+ * \brief Writes a frame to a ST_NICCC file with a given vertex layout
+ * \details See write_frame() for the parameters.
+ * \param[in] banks whether frames with more than 255 vertices are
+ *  indexed with several vertex tables instead of storing the x,y
+ *  coordinates in the polygons
+ * \return true if vertex banks were used
+ */
+bool write_frame_layout(
+    ST_NICCC_IO* io,
+    const GEO::Triangulation& triangulation,
+    const std::vector<GEO::ConvexPolygon>& polygons,
+    int background, int palette_background,
+    std::vector<GEO::index_t>* table,
+    bool banks
+) {
+    if(table != nullptr) {
+        table->clear();
+    }
+    ST_NICCC_FRAME frame;
+    st_niccc_frame_init(&frame);
+    if(background != -1) {
+        // Players clear the screen with palette entry 0
+        st_niccc_frame_clear(&frame);
+        if(background != palette_background) {
+            uint8_t c0 = (background == 0) ? 0 : 255;
+            st_niccc_frame_set_color(&frame, 0, c0, c0, c0);
+            st_niccc_frame_set_color(&frame, 1, 255-c0, 255-c0, 255-c0);
+            palette_background = background;
+        }
+    }
+
+    // Polygons that are written
+    std::vector<GEO::ConvexPolygon> written;
+    for(const GEO::ConvexPolygon& P: polygons) {
+        if(P.color != background) {
+            written.push_back(P);
+        }
+    }
+    
+    // Only keep the vertices of the written polygons (this also skips
+    // the vertices removed by incremental updates)
+    std::vector<GEO::index_t> vertex_index(
+        triangulation.nv(), GEO::index_t(-1)
+    );
+    GEO::index_t nv = 0;
+    for(const GEO::ConvexPolygon& P: written) {
+        for(GEO::index_t v: P.vertices) {
+            nv += (vertex_index[v] == GEO::index_t(-1));
+            vertex_index[v] = 0;
+        }
+    }
+
+    banks = (banks && nv > 255);
+    std::string order = GEO::CmdLine::get_arg("polygon_order");
+    if(banks && order == "triangles") {
+        // Spatial order, so that the banks cover compact regions and
+        // share few vertices.
+        order = "morton";
+    }
+    sort_polygons(triangulation, written, order);
+
+    // In strip order if strips are used
+    std::vector<GEO::ConvexPolygon> strips;
+    std::vector<uint8_t> strip_edge;
+    if(GEO::CmdLine::get_arg_bool("strips")) {
+        build_strips(written, -1, strips, strip_edge);
+    } else {
+        strips.swap(written);
+        strip_edge.assign(strips.size(), 0);
+    }
+
+    // Vertex banks: each one is used by consecutive polygons and has at
+    // most 255 vertices. The vertices of a strip piece that are shared
+    // with the previous polygon are not needed.
+    std::vector<GEO::index_t> bank_begin(1, 0);
+    if(banks) {
+        std::vector<GEO::index_t> vertex_bank(
+            triangulation.nv(), GEO::index_t(-1)
+        );
+        GEO::index_t bank_nv = 0;
+        for(GEO::index_t p=0; p<strips.size(); ++p) {
+            const std::vector<GEO::index_t>& V = strips[p].vertices;
+            GEO::index_t first = (strip_edge[p] == 0) ? 0 : 2;
+            GEO::index_t nb_new = 0;
+            for(GEO::index_t i=first; i<V.size(); ++i) {
+                nb_new += (vertex_bank[V[i]] != bank_begin.size());
+            }
+            if(bank_nv + nb_new > 255) {
+                bank_begin.push_back(p);
+                bank_nv = 0;
+                nb_new = GEO::index_t(V.size()) - first;
+            }
+            for(GEO::index_t i=first; i<V.size(); ++i) {
+                vertex_bank[V[i]] = GEO::index_t(bank_begin.size());
+            }
+            bank_nv += nb_new;
+        }
+    }
+    bank_begin.push_back(GEO::index_t(strips.size()));
+    
+    if(nv <= 255 || banks) {
+        uint8_t X[255];
+        uint8_t Y[255];
+        uint8_t P8[15];
+        std::vector<GEO::index_t> in_bank(
+            triangulation.nv(), GEO::index_t(-1)
+        );
+        for(GEO::index_t b=0; b+1<bank_begin.size(); ++b) {
+            // Vertices of the bank, in the order of the triangulation, or
+            // in the order of their first use by the polygons if they
+            // were sorted, so that consecutive polygons reference
+            // nearby indices.
+            std::vector<GEO::index_t> bank_vertices;
+            if(order != "triangles") {
+                for(GEO::index_t p=bank_begin[b]; p<bank_begin[b+1]; ++p) {
+                    const std::vector<GEO::index_t>& V = strips[p].vertices;
+                    GEO::index_t first = (strip_edge[p] == 0) ? 0 : 2;
+                    for(GEO::index_t i=first; i<V.size(); ++i) {
+                        if(in_bank[V[i]] != b) {
+                            in_bank[V[i]] = b;
+                            bank_vertices.push_back(V[i]);
+                        }
+                    }
+                }
+            } else {
+                for(GEO::index_t v=0; v<triangulation.nv(); ++v) {
+                    if(vertex_index[v] != GEO::index_t(-1)) {
+                        bank_vertices.push_back(v);
+                    }
+                }
+            }
+            for(GEO::index_t i=0; i<bank_vertices.size(); ++i) {
+                GEO::index_t v = bank_vertices[i];
+                vertex_index[v] = i;
+                X[i] = uint8_t(triangulation.get_x(v));
+                Y[i] = uint8_t(triangulation.get_y(v));
+                if(b == 0) {
+                    st_niccc_frame_set_vertex(&frame, uint8_t(i), X[i], Y[i]);
+                }
+            }
+            if(b == 0) {
+                st_niccc_write_frame_header(io,&frame);
+                if(table != nullptr && !banks) {
+                    *table = bank_vertices;
+                }
+            } else {
+                st_niccc_write_vertex_bank(
+                    io, uint8_t(bank_vertices.size()), X, Y
+                );
+            }
+            
+            for(GEO::index_t p=bank_begin[b]; p<bank_begin[b+1]; ++p) {
+                const GEO::ConvexPolygon& P = strips[p];
+                int first = (strip_edge[p] == 0) ? 0 : 2;
+                for(int i=first; i<int(P.vertices.size()); ++i) {
+                    P8[i-first] = uint8_t(vertex_index[P.vertices[i]]);
+                }
+                if(strip_edge[p] == 0) {
+                    st_niccc_write_polygon_indexed(
+                        io,uint8_t(P.color ^ palette_background),
+                        P.vertices.size(),P8
+                    );
+                } else {
+                    st_niccc_write_strip_indexed(
+                        io,strip_edge[p],P.vertices.size()-2,P8
+                    );
+                }
+            }
+        }
+    } else {
+        st_niccc_write_frame_header(io,&frame);
+        uint8_t x[15];
+        uint8_t y[15];
+        for(GEO::index_t p=0; p<strips.size(); ++p) {
+            const GEO::ConvexPolygon& P = strips[p];
+            int first = (strip_edge[p] == 0) ? 0 : 2;
+            for(int i=first; i<int(P.vertices.size()); ++i) {
+                GEO::index_t v = P.vertices[i];
+                x[i-first] = uint8_t(triangulation.get_x(v));
+                y[i-first] = uint8_t(triangulation.get_y(v));
+            }
+            if(strip_edge[p] == 0) {
+                st_niccc_write_polygon(
+                    io,uint8_t(P.color ^ palette_background),
+                    P.vertices.size(),x,y
+                );
+            } else {
+                st_niccc_write_strip(
+                    io,strip_edge[p],P.vertices.size()-2,x,y
+                );
+            }
+        }
+    }
+    st_niccc_write_end_of_frame(io);
+    return banks;
+}
+
+void write_frame(
+    ST_NICCC_IO* io,
+    const GEO::Triangulation& triangulation,
+    const std::vector<GEO::ConvexPolygon>& polygons,
+    int background, int palette_background,
+    std::vector<GEO::index_t>* table
+) {
+    bool banks = GEO::CmdLine::get_arg_bool("vertex_banks");
+    if(banks) {
+        // A vertex table per bank can cost more than the x,y coordinates
+        // in the polygons: keep the smallest encoding.
+        ST_NICCC_IO with_banks;
+        st_niccc_open_counter(&with_banks);
+        if(
+            write_frame_layout(
+                &with_banks, triangulation, polygons,
+                background, palette_background, nullptr, true
+            )
+        ) {
+            ST_NICCC_IO without_banks;
+            st_niccc_open_counter(&without_banks);
+            write_frame_layout(
+                &without_banks, triangulation, polygons,
+                background, palette_background, nullptr, false
+            );
+            banks = (with_banks.addr < without_banks.addr);
+        }
+    }
+    write_frame_layout(
+        io, triangulation, polygons,
+        background, palette_background, table, banks
+    );
+}
+
+/**
+ * \brief Writes a frame that repeats the image of the previous one
+ * \param[in] io the ST_NICCC file, or a counter opened with
+ *  st_niccc_open_counter()
+ */
+void write_hold_frame(ST_NICCC_IO* io) {
+    ST_NICCC_FRAME frame;
+    st_niccc_frame_init(&frame);
+    st_niccc_frame_hold(&frame);
+    st_niccc_write_frame_header(io,&frame);
+    st_niccc_write_end_of_frame(io);
+}
+
+/**
+ * \brief Writes a frame that draws the polygons of the keyframe with a
+ *  new vertex table
+ * \param[in] io the ST_NICCC file, or a counter opened with
+ *  st_niccc_open_counter()
+ * \param[in] X , Y the vertex table, see MotionEncoder
+ * \param[in] clear whether the keyframe was cleared
+ */
+void write_motion_frame(
+    ST_NICCC_IO* io,
+    const std::vector<uint8_t>& X, const std::vector<uint8_t>& Y,
+    bool clear
+) {
+    ST_NICCC_FRAME frame;
+    st_niccc_frame_init(&frame);
+    st_niccc_frame_motion(&frame);
+    if(clear) {
+        st_niccc_frame_clear(&frame);
+    }
+    for(GEO::index_t i=0; i<X.size(); ++i) {
+        st_niccc_frame_set_vertex(&frame, uint8_t(i), X[i], Y[i]);
+    }
+    st_niccc_write_frame_header(io,&frame);
+    st_niccc_write_end_of_frame(io);
+}
+
+GEO::index_t frame_size(
+    const GEO::Triangulation& triangulation,
+    const std::vector<GEO::ConvexPolygon>& polygons,
+    int background, int palette_background
+) {
+    ST_NICCC_IO counter;
+    st_niccc_open_counter(&counter);
+    write_frame(
+        &counter, triangulation, polygons, background, palette_background
+    );
+    return GEO::index_t(counter.addr);
+}
+
+int choose_background(
+    const GEO::Triangulation& triangulation,
+    const std::vector<GEO::ConvexPolygon>& polygons,
+    int palette_background
+) {
+    if(!GEO::CmdLine::get_arg_bool("clear_background")) {
+        return -1;
+    }
+    int same = palette_background;
+    int other = 1 - palette_background;
+    return (
+        frame_size(triangulation, polygons, other, palette_background) <
+        frame_size(triangulation, polygons, same, palette_background)
+    ) ? other : same;
+}
+
+/**
+ * \brief Gets the byte budget of each frame for rate control
+ * \return the number of bytes per frame, or 0 if rate control is
+ *  deactivated
+ */
+GEO::index_t rate_bytes_per_frame() {
+    GEO::index_t result = GEO::index_t(
+        GEO::CmdLine::get_arg_int("rate_bytes_per_frame")
+    );
+    int bitrate = GEO::CmdLine::get_arg_int("rate_bitrate");
+    if(bitrate > 0) {
+        int fps = std::max(GEO::CmdLine::get_arg_int("rate_fps"), 1);
+        result = GEO::index_t(bitrate / (8*fps));
+    }
+    return result;
+}
+
+/**
+ * \brief Gets the bytes carried to the next frames by rate control
+ * \details Unused bytes are carried to the next frames, up to
+ *  rate_buffer frames.
+ * \param[in] budget the byte budget of the frame, including the bytes
+ *  carried from the previous frames
+ * \param[in] size the number of bytes of the encoded frame
+ */
+int next_rate_carry(int budget, int size) {
+    int max_carry = int(rate_bytes_per_frame()) *
+        std::max(GEO::CmdLine::get_arg_int("rate_buffer"), 1);
+    return std::max(std::min(budget - size, max_carry), -max_carry);
+}
+
+void print_predicate_stats(bool frame) {
+    typedef GEO::PCK::PredicateStats PredicateStats;
+    static std::map<const PredicateStats*, std::vector<GEO::Numeric::uint64>>
+        previous;
+    for(
+        const PredicateStats* stats = PredicateStats::first();
+        stats != nullptr; stats = stats->next()
+    ) {
+        std::vector<GEO::Numeric::uint64> count(PredicateStats::NB_COUNTERS);
+        for(GEO::index_t c=0; c<PredicateStats::NB_COUNTERS; ++c) {
+            count[c] = stats->count(PredicateStats::Counter(c));
+        }
+        std::vector<GEO::Numeric::uint64> delta = count;
+        if(frame) {
+            std::vector<GEO::Numeric::uint64>& prev = previous[stats];
+            prev.resize(PredicateStats::NB_COUNTERS, 0);
+            for(GEO::index_t c=0; c<PredicateStats::NB_COUNTERS; ++c) {
+                delta[c] -= prev[c];
+            }
+            prev = count;
+        }
+        if(delta[PredicateStats::INVOKE] == 0) {
+            continue;
+        }
+        std::cerr << (frame ? "Predicate " : "Predicate (total) ")
+                  << stats->name() << ": "
+                  << delta[PredicateStats::INVOKE] << " invocations, "
+                  << delta[PredicateStats::FILTER_FAILURE]
+                  << " filter failures, "
+                  << delta[PredicateStats::EXACT] << " exact, "
+                  << delta[PredicateStats::SOS] << " SOS" << std::endl;
+    }
+}
+
+int load_fig(
+    std::istream& in, const std::string& filename,
+    GEO::PolylinesSimplifier& polylines
+) {
+    int nb_paths = 0;
+    int xmin = 0;
+    int xmax = 0;
+    int ymin = 0;
+    int ymax = 0;
+    int L = 0;
+
+    static int win_xmin = 1000;
+    static int win_xmax = -1;
+    static int win_ymin = 1000;
+    static int win_ymax = -1;
+
+    {
+        std::string line;
+        while(std::getline(in,line)) {
+            int	object_code;    // always 3
+            int	sub_type;       // 0: open approximated spline
+                                // 1: closed approximated spline
+	                        // 2: open   interpolated spline
+	                        // 3: closed interpolated spline
+	                        // 4: open   x-spline
+	                        // 5: closed x-spline
+            int	line_style;     // enumeration type, solid, dash, dotted, etc.
+            int	thickness;      // 1/80 inch
+            int	pen_color;      // enumeration type, pen color
+            int	fill_color;     // enumeration type, fill color
+            int	depth;          // enumeration type
+            int	pen_style;      // pen style, not used
+            int	area_fill;      // enumeration type, -1 = no fill
+            float style_val;    // 1/80 inch,specification for dash/dotted lines
+            int	cap_style;      // enumeration type, only used for open splines
+            int	forward_arrow;  // 0: off, 1: on
+            int	backward_arrow; // 0: off, 1: on
+            int	npoints	;       // number of control points in spline
+
+            int xmin_tmp, ymin_tmp, xmax_tmp, ymax_tmp;
+            
+            if( // object 3: polyline
+                sscanf(
+                    line.c_str(),
+                    "%d %d %d %d %d %d %d %d %d %f %d %d %d %d",
+                    &object_code, &sub_type, &line_style, &thickness,
+                    &pen_color, &fill_color, &depth, &pen_style, &area_fill,
+                    &style_val, &cap_style, &forward_arrow, &backward_arrow,
+                    &npoints
+                ) == 14 &&
+                object_code==3
+            ) {
+                polylines.begin_polyline();
+                bool update_win = (win_xmax == -1 && win_ymax == -1);
+                for(int i=0; i<npoints; ++i) {
+                    std::getline(in,line);
+                    int x,y;
+                    if(sscanf(line.c_str(), "%d %d", &x, &y) != 2) {
+                        std::cerr << "error while loading "
+                                  << filename
+                                  << std::endl;
+                        exit(-1);
+                    }
+                    x = std::max(x,xmin);
+                    x = std::min(x,xmax);
+                    y = std::max(y,ymin);
+                    y = std::min(y,ymax);
+                    x = (x-xmin)*255/L;
+                    y = (y-ymin)*255/L;
+
+                    if(update_win) {
+                        win_xmin = std::min(win_xmin,x);
+                        win_xmax = std::max(win_xmax,y);
+                        win_ymin = std::min(win_ymin,x);
+                        win_ymax = std::max(win_ymax,y);                        
+                    }
+                    polylines.add_point(x,y);
+                }
+                ++nb_paths;
+            } else if( // object 6: bounding box
+                sscanf(
+                    line.c_str(),
+                    "%d %d %d %d %d",
+                    &object_code, &xmin_tmp, &ymin_tmp, &xmax_tmp, &ymax_tmp
+                ) == 5 &&
+                object_code == 6
+            ) {
+                xmin = xmin_tmp;
+                ymin = ymin_tmp;
+                xmax = xmax_tmp;
+                ymax = ymax_tmp;
+                L = xmax - xmin;
+            }
+        }
+
+    }
+    return nb_paths;
+}
+
+/**
+ * \brief Maximum number of levels of detail of a frame
+ */
+const int MAX_LOD_LEVELS = 4;
+
+void configure_triangulation(GEO::Triangulation& triangulation) {
+    triangulation.set_delaunay(true);
+    triangulation.set_grid_predicates(
+        GEO::CmdLine::get_arg_bool("grid_predicates")
+    );
+    triangulation.set_pred_cache_max_size(
+        GEO::index_t(GEO::CmdLine::get_arg_int("pred_cache_max_size"))
+    );
+    triangulation.set_batch_insert(
+        GEO::CmdLine::get_arg_bool("batch_insert")
+    );
+    triangulation.set_bulk_constraints(
+        GEO::CmdLine::get_arg_bool("bulk_constraints")
+    );
+    triangulation.set_classify_border(
+        GEO::CmdLine::get_arg_bool("classify_border")
+    );
+}
+
+// Parse .fig file and append content to ST_NICCC file
+// Reference: https://mcj.sourceforge.net/fig-format.html
+bool fig_2_ST_NICCC(const std::string& filename, ST_NICCC_IO* io) {
+
+    // Kept from one frame to the next for incremental updates
+    static GEO::Triangulation triangulation;
+    configure_triangulation(triangulation);
+
+    // The coarser levels of detail
+    static GEO::Triangulation lod_triangulations[MAX_LOD_LEVELS-1];
+    
+    // Bytes not used by the previous frames (or used in excess if
+    // negative), for rate control.
+    static int rate_carry = 0;
+
+    // Color in palette entry 0, see write_frame()
+    static int palette_background = 0;
+
+    // Polylines of the last frame that was not a hold frame
+    static GEO::PolylinesSimplifier held_polylines;
+    static GEO::Numeric::uint64 held_hash = 0;
+    static bool has_held = false;
+
+    // Keyframe of the motion frames
+    static GEO::MotionEncoder motion;
+    
+    std::ifstream in(filename);
+    if(!in) {
+        return false;
+    }
+    std::cerr << "Loading " << filename << std::endl;
+    GEO::StageProfiler::instance().begin_frame(
+        filename.substr(filename.find_last_of('/') + 1)
+    );
+    int nb_paths = 0;
+    GEO::PolylinesSimplifier polylines;
+
+    // Read xfig file
+    {
+        GEO::StageProfiler::Timer timer(GEO::StageProfiler::PARSE);
+        nb_paths = load_fig(in, filename, polylines);
+        if(GEO::CmdLine::get_arg_bool("prune")) {
+            polylines.prune();
+        }
+    }
+    if(GEO::CmdLine::get_arg_bool("prune")) {
+        std::cerr << "Pruned: " << polylines.nb_pruned_points()
+                  << " points (duplicated: "
+                  << polylines.nb_pruned_duplicated()
+                  << ", collinear: " << polylines.nb_pruned_collinear()
+                  << "), degenerate paths: "
+                  << polylines.nb_pruned_degenerate() << std::endl;
+    }
+
+    // Repeat of the previous frame: no need to triangulate
+    GEO::Numeric::uint64 hash = polylines.hash();
+    int hold_tolerance = GEO::CmdLine::get_arg_int("hold_tolerance");
+    if(
+        GEO::CmdLine::get_arg_bool("hold") && has_held &&
+        (hash == held_hash || hold_tolerance > 0) &&
+        polylines.is_close(held_polylines, hold_tolerance)
+    ) {
+        {
+            GEO::StageProfiler::Timer timer(GEO::StageProfiler::WRITE);
+            write_hold_frame(io);
+        }
+        GEO::index_t bytes_per_frame = rate_bytes_per_frame();
+        if(bytes_per_frame != 0) {
+            int budget = int(bytes_per_frame) + rate_carry;
+            ST_NICCC_IO counter;
+            st_niccc_open_counter(&counter);
+            write_hold_frame(&counter);
+            rate_carry = next_rate_carry(budget, int(counter.addr));
+        }
+        std::cerr << "Hold: same as previous frame" << std::endl;
+        GEO::StageProfiler::instance().end_frame();
+        std::cerr << "Loaded " << nb_paths << " paths" << std::endl;
+        return true;
+    }
+    held_polylines = polylines;
+    held_hash = hash;
+    has_held = true;
+
+    // Same polylines as the keyframe with moved points: only the vertex
+    // table is written.
+    int nb_levels = std::min(
+        std::max(GEO::CmdLine::get_arg_int("lod_levels"), 1), MAX_LOD_LEVELS
+    );
+    bool use_motion = GEO::CmdLine::get_arg_bool("motion") && nb_levels == 1;
+    std::vector<uint8_t> motion_X;
+    std::vector<uint8_t> motion_Y;
+    if(
+        use_motion && motion.move(
+            polylines, GEO::CmdLine::get_arg_double("motion_max_distance"),
+            motion_X, motion_Y
+        )
+    ) {
+        {
+            GEO::StageProfiler::Timer timer(GEO::StageProfiler::WRITE);
+            write_motion_frame(io, motion_X, motion_Y, motion.clear_bit());
+        }
+        GEO::index_t bytes_per_frame = rate_bytes_per_frame();
+        if(bytes_per_frame != 0) {
+            int budget = int(bytes_per_frame) + rate_carry;
+            ST_NICCC_IO counter;
+            st_niccc_open_counter(&counter);
+            write_motion_frame(
+                &counter, motion_X, motion_Y, motion.clear_bit()
+            );
+            rate_carry = next_rate_carry(budget, int(counter.addr));
+        }
+        std::cerr << "Motion: " << motion_X.size()
+                  << " vertices moved from keyframe" << std::endl;
+        GEO::StageProfiler::instance().end_frame();
+        std::cerr << "Loaded " << nb_paths << " paths" << std::endl;
+        return true;
+    }
+
+    // Send contents to constrained Delaunay triangulation and
+    // partition triangles into convex polygons
+    std::vector<GEO::ConvexPolygon> polygons;
+    if(
+        !GEO::CmdLine::get_arg_bool("incremental") ||
+        !update_triangulation(triangulation, polylines)
+    ) {
+        triangulate_polylines(triangulation, polylines);
+    }
+    //triangulation.save(filename+"_triangulation.obj");
+    polygonize(triangulation, polygons);
+
+    // Rate control: simplify the polylines with increasing tolerance
+    // until the frame fits in its budget.
+    GEO::index_t bytes_per_frame = rate_bytes_per_frame();
+    if(bytes_per_frame != 0) {
+        int budget = int(bytes_per_frame) + rate_carry;
+        int size = int(frame_size(
+            triangulation, polygons,
+            choose_background(triangulation, polygons, palette_background),
+            palette_background
+        ));
+        double tolerance = 0.0;
+        double max_tolerance = GEO::CmdLine::get_arg_double(
+            "rate_max_tolerance"
+        );
+        while(size > budget && tolerance < max_tolerance) {
+            tolerance = std::min(
+                (tolerance == 0.0) ? 0.5 : tolerance * 1.5, max_tolerance
+            );
+            polylines.simplify(0, tolerance);
+            triangulate_polylines(triangulation, polylines);
+            polygonize(triangulation, polygons);
+            size = int(frame_size(
+                triangulation, polygons,
+                choose_background(triangulation, polygons, palette_background),
+                palette_background
+            ));
+        }
+        rate_carry = next_rate_carry(budget, size);
+        std::cerr << "Rate: " << size << " bytes (budget: " << budget
+                  << "), tolerance: " << tolerance
+                  << ", error: " << polylines.error() << std::endl;
+    }
+    
+    // Levels of detail: the polylines are simplified further with
+    // a tolerance that doubles at each level.
+    GEO::Triangulation* level_triangulation[MAX_LOD_LEVELS];
+    std::vector<GEO::ConvexPolygon>* level_polygons[MAX_LOD_LEVELS];
+    std::vector<GEO::ConvexPolygon> lod_polygons[MAX_LOD_LEVELS-1];
+    level_triangulation[0] = &triangulation;
+    level_polygons[0] = &polygons;
+    double lod_tolerance = GEO::CmdLine::get_arg_double("lod_tolerance");
+    for(int l=1; l<nb_levels; ++l) {
+        GEO::PolylinesSimplifier level_polylines = polylines;
+        level_polylines.simplify(0, lod_tolerance * double(1 << (l-1)));
+        level_triangulation[l] = &lod_triangulations[l-1];
+        level_polygons[l] = &lod_polygons[l-1];
+        configure_triangulation(*level_triangulation[l]);
+        triangulate_polylines(*level_triangulation[l], level_polylines);
+        polygonize(*level_triangulation[l], *level_polygons[l]);
+    }
+    
+    // Write data to ST_NICCC file
+    {
+        GEO::StageProfiler::Timer timer(GEO::StageProfiler::WRITE);
+        int background = choose_background(
+            triangulation, polygons, palette_background
+        );
+        // All the levels use the same background, so that the
+        // palette does not depend on the level read by the player.
+        // The size of a level is a word. If a level does not fit,
+        // only the finest level is written.
+        uint16_t sizes[MAX_LOD_LEVELS];
+        bool sizes_fit = true;
+        for(int l=0; l<nb_levels && nb_levels > 1; ++l) {
+            GEO::index_t size = frame_size(
+                *level_triangulation[l], *level_polygons[l],
+                background, palette_background
+            );
+            sizes_fit = sizes_fit && (size <= 65535);
+            sizes[l] = uint16_t(size);
+        }
+        if(nb_levels > 1 && !sizes_fit) {
+            std::cerr << "LOD: level larger than 65535 bytes,"
+                      << " writing the finest level only" << std::endl;
+        }
+        if(nb_levels > 1 && sizes_fit) {
+            st_niccc_write_lod_header(io, uint8_t(nb_levels), sizes);
+            for(int l=0; l<nb_levels; ++l) {
+                write_frame(
+                    io, *level_triangulation[l], *level_polygons[l],
+                    background, palette_background
+                );
+            }
+            std::cerr << "LOD:";
+            for(int l=0; l<nb_levels; ++l) {
+                std::cerr << " " << sizes[l];
+            }
+            std::cerr << " bytes" << std::endl;
+        } else {
+            std::vector<GEO::index_t> table;
+            write_frame(
+                io, triangulation, polygons, background, palette_background,
+                &table
+            );
+            if(use_motion) {
+                motion.set_keyframe(
+                    triangulation, polygons, polylines, table,
+                    background != -1
+                );
+            }
+        }
+        if(background != -1) {
+            palette_background = background;
+        }
+    }
+
+    if(GEO::CmdLine::get_arg_bool("pred_cache_stats")) {
+        const GEO::OrientCache& cache = triangulation.pred_cache();
+        double nb_lookups = double(
+            std::max(cache.nb_lookups(), GEO::Numeric::uint64(1))
+        );
+        std::cerr << "Predicate cache: " << cache.nb_lookups()
+                  << " lookups, hit rate: "
+                  << 100.0 * double(cache.nb_hits()) / nb_lookups
+                  << "%, probes per lookup: "
+                  << double(cache.nb_probes()) / nb_lookups
+                  << ", size: " << cache.size() << std::endl;
+        triangulation.pred_cache().reset_stats();
+    }
+
+    if(GEO::CmdLine::get_arg_bool("locate_stats")) {
+        double nb_locate = double(
+            std::max(triangulation.nb_locate(), GEO::Numeric::uint64(1))
+        );
+        std::cerr << "Locate: " << triangulation.nb_locate()
+                  << " points, traversed triangles per point: "
+                  << double(triangulation.nb_locate_traversed_T()) / nb_locate
+                  << std::endl;
+        triangulation.reset_locate_stats();
+    }
+
+    if(GEO::CmdLine::get_arg_bool("swap_stats")) {
+        std::cerr << "Swaps: " << triangulation.nb_swaps()
+                  << ", inserting constraints: "
+                  << triangulation.nb_constraints_swaps() << std::endl;
+        triangulation.reset_swap_stats();
+    }
+
+    if(GEO::CmdLine::get_arg_bool("expansion_stats")) {
+        const GEO::ExpansionPool& pool = triangulation.expansion_pool();
+        std::cerr << "Expansions: " << pool.nb_allocations()
+                  << " allocations, " << pool.nb_bytes()
+                  << " bytes, reserved: " << pool.reserved_bytes()
+                  << " bytes" << std::endl;
+        triangulation.expansion_pool().reset_stats();
+    }
+
+    if(GEO::CmdLine::get_arg_bool("pred_stats")) {
+        print_predicate_stats(true);
+    }
+    
+    GEO::StageProfiler::instance().end_frame();
+    std::cerr << "Loaded " << nb_paths << " paths" << std::endl;
+    return true;
+}
+
+void begin_stream(ST_NICCC_IO* io) {
+    ST_NICCC_FRAME frame;
+    st_niccc_frame_init(&frame);
+    st_niccc_frame_set_color(&frame, 0,   0,   0,   0);
+    st_niccc_frame_set_color(&frame, 1, 255, 255, 255);
+    st_niccc_write_frame_header(io,&frame);
+    st_niccc_write_end_of_frame(io);
+}
+
+void end_stream(ST_NICCC_IO* io) {
+    ST_NICCC_FRAME frame;
+    st_niccc_frame_init(&frame);
+    st_niccc_write_frame_header(io,&frame);
+    st_niccc_write_end_of_stream(io);
+}
+
+void declare_encoder_args() {
+    GEO::CmdLine::declare_arg(
+        "incremental",false,
+        "update the constraints of the triangulation of the previous frame"
+        " (classification and polygonization are not incremental)"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "grid_predicates",true,
+        "use integer predicates for points with integer coordinates"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "pred_cache_max_size",1048576,
+        "maximum number of cached orientation predicates or 0 (no cache)"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "pred_cache_stats",false,
+        "display predicate cache statistics for each frame"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "batch_insert",true,
+        "insert the points in spatial sort order"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "locate_stats",false,
+        "display point location statistics for each frame"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "bulk_constraints",true,
+        "restore Delaunay condition once for all the constraints"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "classify_border",false,
+        "fill the shapes cut by the border of the frame"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "swap_stats",false,
+        "display the number of edge swaps for each frame"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "expansion_stats",false,
+        "display allocations for the intersections for each frame"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "pred_stats",false,
+        "display exact predicate statistics for each frame and the run"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "timings",false,
+        "display the time spent in each stage at exit"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "timings_top",5,
+        "number of slowest frames displayed by timings"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "timings_file","",
+        "save the time of each stage for each frame (.csv or .json)"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "clear_background",true,
+        "clear frames with one color and only write the polygons of the other"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "lod_levels",1,
+        "number of levels of detail of each frame (1 to 4)"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "lod_tolerance",1.0,
+        "simplification tolerance of the first coarser level of detail"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "motion",false,
+        "encode frames that only move the points of the keyframe"
+        " as vertex tables"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "motion_max_distance",8.0,
+        "maximum distance a point can move in a motion frame"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "vertex_banks",false,
+        "index frames with more than 255 vertices with several vertex tables"
+        " when smaller (needs a player that knows VERTEX_BANK)"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "polygon_order","morton",
+        "order of the polygons in a frame,"
+        " one of triangles,morton,hilbert,scanline"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "strips",false,
+        "send polygons that share an edge with the previous one as strips"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "hold",true,
+        "encode the repeats of the previous frame as hold frames"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "hold_tolerance",0,
+        "maximum move of the points in a hold frame"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "prune",true,
+        "remove duplicated and collinear points and flat paths"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "simplify",true,
+        "simplify frames that have more than 255 vertices"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "simplify_max_error",2.0,
+        "maximum distance between simplified and original paths"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "rate_bytes_per_frame",0,
+        "target size of the frames in bytes or 0 (no rate control)"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "rate_bitrate",0,
+        "target bitrate in bits per second or 0 (use rate_bytes_per_frame)"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "rate_fps",12,"frames per second, used with rate_bitrate"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "rate_buffer",12,
+        "maximum number of frames of unused budget carried to next frames"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "rate_max_tolerance",16.0,
+        "maximum simplification tolerance used by rate control"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "polygonize","greedy",
+        "convex partition of triangles, one of greedy,optimized"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "polygonize_stats",false,
+        "compare the optimized convex partition with the greedy one"
+    );
+}
@@ -0,0 +1,3125 @@
+/*
+ * The encoder of triangulate: converts the polylines of .fig files into
+ *  convex polygons, written to a ST_NICCC stream. Also used by vectorize
+ *  and frame_benchmark.
+ */
+
+#ifndef TRIANGULATE_ENCODER_H
+#define TRIANGULATE_ENCODER_H
+
+#include "Delaunay_psm.h"
+#include "ST_NICCC/io.h"
+
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <queue>
+#include <functional>
+#include <memory>
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+
+
+namespace GEO {
+
+    /**
+     * \brief A convex polygon of a given color, with its
+     *  vertices in counter-clockwise order.
+     */
+    struct ConvexPolygon {
+        int color;
+        std::vector<index_t> vertices;
+    };
+
+    /**
+     * \brief Measures elapsed wall-clock time
+     * \details Stopwatch measures process time with a 1/100 s
+     *  resolution, too coarse for stages that take a fraction of
+     *  a millisecond.
+     */
+    class WallClock {
+    public:
+        WallClock() : start_(std::chrono::steady_clock::now()) {
+        }
+
+        /**
+         * \brief Gets the elapsed time since construction, in seconds
+         */
+        double elapsed_time() const {
+            return std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start_
+            ).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    /**
+     * \brief Collects the time spent in each stage of the encoder
+     *  for each frame.
+     * \details Stages are timed with a StageProfiler::Timer. The time
+     *  of a stage executed several times in a frame (for instance, when
+     *  the polylines are simplified) is accumulated.
+     */
+    class StageProfiler {
+    public:
+        enum Stage {
+            PARSE, POINTS, CONSTRAINTS, CLASSIFY, POLYGONIZE, WRITE,
+            NB_STAGES
+        };
+
+        /**
+         * \brief Times a stage during its lifetime
+         */
+        class Timer {
+        public:
+            Timer(Stage stage) : stage_(stage) {
+            }
+
+            ~Timer() {
+                StageProfiler::instance().add(stage_, W_.elapsed_time());
+            }
+
+        private:
+            Stage stage_;
+            WallClock W_;
+        };
+
+        static StageProfiler& instance() {
+            static StageProfiler result;
+            return result;
+        }
+
+        static const char* stage_name(index_t stage) {
+            static const char* names[NB_STAGES+2] = {
+                "parse", "points", "constraints", "classify",
+                "polygonize", "write", "other", "total"
+            };
+            return names[stage];
+        }
+
+        /**
+         * \brief Enables or disables recording
+         * \details When disabled (the default), begin_frame() does
+         *  not record anything, and the timers are ignored.
+         */
+        void set_enabled(bool x) {
+            enabled_ = x;
+        }
+
+        /**
+         * \brief Starts a new frame
+         * \param[in] name the name of the frame
+         */
+        void begin_frame(const std::string& name) {
+            if(!enabled_) {
+                return;
+            }
+            Frame F;
+            F.name = name;
+            F.time.assign(NB_STAGES+2, 0.0);
+            frames_.push_back(F);
+            frame_W_ = std::make_shared<WallClock>();
+        }
+
+        /**
+         * \brief Terminates the current frame
+         * \details The time not spent in the stages is
+         *  accumulated in "other"
+         */
+        void end_frame() {
+            if(frames_.empty() || frame_W_ == nullptr) {
+                return;
+            }
+            Frame& F = frames_.back();
+            double total = frame_W_->elapsed_time();
+            double stages = 0.0;
+            for(index_t s=0; s<NB_STAGES; ++s) {
+                stages += F.time[s];
+            }
+            F.time[NB_STAGES] = std::max(total - stages, 0.0);
+            F.time[NB_STAGES+1] = total;
+            frame_W_.reset();
+        }
+
+        void add(Stage stage, double seconds) {
+            if(!frames_.empty()) {
+                frames_.back().time[stage] += seconds;
+            }
+        }
+
+        /**
+         * \brief Displays the total, mean, percentiles and maximum of
+         *  each stage and the slowest frames
+         * \param[in] out the stream
+         * \param[in] top_n number of slowest frames to display
+         */
+        void print_summary(std::ostream& out, index_t top_n) const {
+            if(frames_.empty()) {
+                return;
+            }
+            char line[256];
+            out << "Profile: " << frames_.size() << " frames" << std::endl;
+            snprintf(
+                line, sizeof(line), "%-12s %10s %8s %8s %8s %8s %8s",
+                "stage (ms)", "total", "mean", "p50", "p90", "p99", "max"
+            );
+            out << line << std::endl;
+            for(index_t s=0; s<NB_STAGES+2; ++s) {
+                std::vector<double> T;
+                double total = 0.0;
+                for(const Frame& F : frames_) {
+                    T.push_back(1000.0 * F.time[s]);
+                    total += 1000.0 * F.time[s];
+                }
+                std::sort(T.begin(), T.end());
+                snprintf(
+                    line, sizeof(line),
+                    "%-12s %10.2f %8.3f %8.3f %8.3f %8.3f %8.3f",
+                    stage_name(s), total, total / double(T.size()),
+                    percentile(T, 50.0), percentile(T, 90.0),
+                    percentile(T, 99.0), T.back()
+                );
+                out << line << std::endl;
+            }
+            std::vector<index_t> order(frames_.size());
+            for(index_t f=0; f<order.size(); ++f) {
+                order[f] = f;
+            }
+            std::sort(
+                order.begin(), order.end(),
+                [this](index_t f1, index_t f2)->bool {
+                    return frames_[f1].time[NB_STAGES+1] >
+                           frames_[f2].time[NB_STAGES+1];
+                }
+            );
+            top_n = std::min(top_n, index_t(order.size()));
+            out << "Slowest frames:" << std::endl;
+            for(index_t i=0; i<top_n; ++i) {
+                const Frame& F = frames_[order[i]];
+                out << "  " << F.name << ": "
+                    << 1000.0 * F.time[NB_STAGES+1] << " ms (";
+                for(index_t s=0; s<=NB_STAGES; ++s) {
+                    out << (s == 0 ? "" : ", ") << stage_name(s) << " "
+                        << 1000.0 * F.time[s];
+                }
+                out << ")" << std::endl;
+            }
+        }
+
+        /**
+         * \brief Saves the time of each stage for each frame,
+         *  in milliseconds
+         * \param[in] filename the name of the file, in JSON format if
+         *  its extension is .json, else in CSV format
+         * \retval true on success
+         * \retval false otherwise
+         */
+        bool save(const std::string& filename) const {
+            std::ofstream out(filename);
+            if(!out) {
+                return false;
+            }
+            bool json = (
+                filename.length() >= 5 &&
+                filename.substr(filename.length()-5) == ".json"
+            );
+            if(json) {
+                out << "{" << std::endl << "  \"frames\": [" << std::endl;
+                for(index_t f=0; f<frames_.size(); ++f) {
+                    const Frame& F = frames_[f];
+                    out << "    { \"name\": \"" << F.name << "\"";
+                    for(index_t s=0; s<NB_STAGES+2; ++s) {
+                        out << ", \"" << stage_name(s) << "\": "
+                            << 1000.0 * F.time[s];
+                    }
+                    out << " }" << (f+1 < frames_.size() ? "," : "")
+                        << std::endl;
+                }
+                out << "  ]" << std::endl << "}" << std::endl;
+            } else {
+                out << "frame";
+                for(index_t s=0; s<NB_STAGES+2; ++s) {
+                    out << "," << stage_name(s);
+                }
+                out << std::endl;
+                for(const Frame& F : frames_) {
+                    out << F.name;
+                    for(index_t s=0; s<NB_STAGES+2; ++s) {
+                        out << "," << 1000.0 * F.time[s];
+                    }
+                    out << std::endl;
+                }
+            }
+            return true;
+        }
+
+    protected:
+        /**
+         * \brief Gets a percentile with the nearest-rank method
+         * \param[in] T the sorted values
+         * \param[in] p the percentile, in [0,100]
+         */
+        static double percentile(const std::vector<double>& T, double p) {
+            index_t rank = index_t(std::ceil(p / 100.0 * double(T.size())));
+            return T[std::max(rank, index_t(1)) - 1];
+        }
+
+    private:
+        struct Frame {
+            std::string name;
+            // One entry per stage, then "other" and "total", in seconds
+            std::vector<double> time;
+        };
+        bool enabled_ = false;
+        std::vector<Frame> frames_;
+        std::shared_ptr<WallClock> frame_W_;
+    };
+
+    /**
+     * \brief Simplifies a set of closed polylines with integer
+     *  coordinates, until the number of distinct points fits
+     *  a given budget.
+     * \details Vertices are removed by increasing error, that is, the
+     *  maximum distance between the original vertices and the simplified
+     *  polyline. A vertex is not removed if the triangle formed with its
+     *  two neighbors contains another vertex, so that the polylines do
+     *  not cross each other more than they did before.
+     */
+    class PolylinesSimplifier {
+    public:
+        
+        /**
+         * \brief Starts a new polyline
+         */
+        void begin_polyline() {
+            polyline_first_.push_back(index_t(x_.size()));
+        }
+
+        /**
+         * \brief Adds a point to the current polyline
+         * \param[in] x , y the coordinates of the point, in [0,255]
+         */
+        void add_point(int x, int y) {
+            x_.push_back(x);
+            y_.push_back(y);
+        }
+
+        /**
+         * \brief Gets the number of polylines
+         */
+        index_t nb_polylines() const {
+            return index_t(polyline_first_.size());
+        }
+
+        /**
+         * \brief Removes the points that do not change the geometry
+         * \details Removes the consecutive duplicated points (including
+         *  the last one if it is the same as the first one) and the
+         *  points that are exactly in the middle of the segment formed
+         *  by their two neighbors, then drops the polylines that have
+         *  less than three points or that are flat. The quantized
+         *  coordinates often make adjacent points collapse, and each
+         *  of them costs a point insertion and a constraint insertion
+         *  in the triangulation. Needs to be called before simplify().
+         */
+        void prune() {
+            geo_assert(alive_.size() == 0);
+            std::vector<int> x;
+            std::vector<int> y;
+            std::vector<index_t> polyline_first;
+            std::vector<int> X;
+            std::vector<int> Y;
+            for(index_t p=0; p<nb_polylines(); ++p) {
+                index_t b = polyline_first_[p];
+                index_t e = polyline_end(p);
+                X.resize(0);
+                Y.resize(0);
+                for(index_t v=b; v<e; ++v) {
+                    if(
+                        X.size() == 0 || x_[v] != X.back() || y_[v] != Y.back()
+                    ) {
+                        X.push_back(x_[v]);
+                        Y.push_back(y_[v]);
+                    }
+                }
+                while(
+                    X.size() > 1 && X.back() == X.front() &&
+                    Y.back() == Y.front()
+                ) {
+                    X.pop_back();
+                    Y.pop_back();
+                }
+                nb_pruned_duplicated_ += (e-b) - index_t(X.size());
+
+                // Points in the middle of their two neighbors. Removing
+                // a point can make one of its neighbors removable, hence
+                // the loop.
+                bool changed = true;
+                while(changed && X.size() >= 3) {
+                    changed = false;
+                    for(index_t i=0; i<index_t(X.size()) && X.size()>=3; ) {
+                        index_t n = index_t(X.size());
+                        index_t ip = (i == 0) ? n-1 : i-1;
+                        index_t in = (i+1 == n) ? 0 : i+1;
+                        Numeric::int64 ux = X[i]  - X[ip];
+                        Numeric::int64 uy = Y[i]  - Y[ip];
+                        Numeric::int64 vx = X[in] - X[i];
+                        Numeric::int64 vy = Y[in] - Y[i];
+                        if(ux*vy - uy*vx == 0 && ux*vx + uy*vy > 0) {
+                            X.erase(X.begin() + std::ptrdiff_t(i));
+                            Y.erase(Y.begin() + std::ptrdiff_t(i));
+                            ++nb_pruned_collinear_;
+                            changed = true;
+                        } else {
+                            ++i;
+                        }
+                    }
+                }
+
+                bool flat = true;
+                for(index_t i=2; i<index_t(X.size()) && flat; ++i) {
+                    flat = (
+                        Numeric::int64(X[1]-X[0]) * Numeric::int64(Y[i]-Y[0]) ==
+                        Numeric::int64(Y[1]-Y[0]) * Numeric::int64(X[i]-X[0])
+                    );
+                }
+                if(flat) {
+                    nb_pruned_degenerate_points_ += index_t(X.size());
+                    ++nb_pruned_degenerate_;
+                    continue;
+                }
+                polyline_first.push_back(index_t(x.size()));
+                x.insert(x.end(), X.begin(), X.end());
+                y.insert(y.end(), Y.begin(), Y.end());
+            }
+            x_.swap(x);
+            y_.swap(y);
+            polyline_first_.swap(polyline_first);
+        }
+
+        /**
+         * \brief Gets the number of points removed by prune()
+         */
+        index_t nb_pruned_points() const {
+            return
+                nb_pruned_duplicated_ + nb_pruned_collinear_ +
+                nb_pruned_degenerate_points_;
+        }
+
+        /**
+         * \brief Gets the number of duplicated points removed by prune()
+         */
+        index_t nb_pruned_duplicated() const {
+            return nb_pruned_duplicated_;
+        }
+
+        /**
+         * \brief Gets the number of collinear points removed by prune()
+         */
+        index_t nb_pruned_collinear() const {
+            return nb_pruned_collinear_;
+        }
+
+        /**
+         * \brief Gets the number of polylines removed by prune()
+         */
+        index_t nb_pruned_degenerate() const {
+            return nb_pruned_degenerate_;
+        }
+
+        /**
+         * \brief Computes a hash of the points of the polylines
+         * \details Only the points given to add_point() and prune() are
+         *  taken into account, not the ones removed by simplify().
+         */
+        Numeric::uint64 hash() const {
+            Numeric::uint64 h = 1469598103934665603ull; // FNV-1a
+            auto add = [&h](index_t i) {
+                for(index_t b=0; b<4; ++b) {
+                    h ^= Numeric::uint64((i >> (8*b)) & 255);
+                    h *= 1099511628211ull;
+                }
+            };
+            for(index_t p=0; p<nb_polylines(); ++p) {
+                add(polyline_end(p) - polyline_first_[p]);
+            }
+            for(index_t v=0; v<x_.size(); ++v) {
+                add(pixel(v));
+            }
+            return h;
+        }
+
+        /**
+         * \brief Tests whether two sets of polylines have the same
+         *  structure and points that do not move more than a tolerance
+         * \details Like hash(), the points removed by simplify() are
+         *  taken into account.
+         * \param[in] rhs the other polylines
+         * \param[in] tolerance maximum difference for each coordinate
+         */
+        bool is_close(const PolylinesSimplifier& rhs, int tolerance) const {
+            if(
+                x_.size() != rhs.x_.size() ||
+                polyline_first_ != rhs.polyline_first_
+            ) {
+                return false;
+            }
+            for(index_t v=0; v<x_.size(); ++v) {
+                if(
+                    std::abs(x_[v] - rhs.x_[v]) > tolerance ||
+                    std::abs(y_[v] - rhs.y_[v]) > tolerance
+                ) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * \brief Gets the points of a polyline
+         * \param[in] p the index of the polyline
+         * \param[out] x , y the coordinates of the points that were not
+         *  removed by simplify()
+         */
+        void get_polyline(
+            index_t p, std::vector<int>& x, std::vector<int>& y
+        ) const {
+            x.resize(0);
+            y.resize(0);
+            index_t b = polyline_first_[p];
+            index_t e = polyline_end(p);
+            for(index_t v=b; v<e; ++v) {
+                if(alive_.size() == 0 || alive_[v]) {
+                    x.push_back(x_[v]);
+                    y.push_back(y_[v]);
+                }
+            }
+        }
+
+        /**
+         * \brief Gets the number of distinct points
+         */
+        index_t nb_distinct_points() const {
+            if(alive_.size() == 0) {
+                std::vector<bool> used(256*256,false);
+                index_t result = 0;
+                for(index_t v=0; v<x_.size(); ++v) {
+                    if(!used[pixel(v)]) {
+                        used[pixel(v)] = true;
+                        ++result;
+                    }
+                }
+                return result;
+            }
+            return nb_distinct_;
+        }
+
+        /**
+         * \brief Gets the maximum distance between the original points
+         *  and the simplified polylines.
+         */
+        double error() const {
+            return error_;
+        }
+        
+        /**
+         * \brief Removes points until the number of distinct points
+         *  is smaller than a given budget.
+         * \details Can be called several times with a decreasing budget.
+         * \param[in] max_nb_points the budget
+         * \param[in] max_error do not remove points that would
+         *  introduce an error larger than this distance
+         * \retval true if the budget could be met
+         * \retval false otherwise
+         */
+        bool simplify(index_t max_nb_points, double max_error) {
+            if(alive_.size() == 0) {
+                init();
+            }
+            while(nb_distinct_ > max_nb_points && !queue_.empty()) {
+                double cost = queue_.top().first;
+                index_t v = queue_.top().second.first;
+                index_t stamp = queue_.top().second.second;
+                if(cost > max_error) {
+                    break;
+                }
+                queue_.pop();
+                if(!alive_[v] || stamp != stamp_[v]) {
+                    continue; // outdated entry
+                }
+                if(polyline_size_[polyline_[v]] <= 3 || !can_remove(v)) {
+                    continue; // may become removable when neighbors change
+                }
+                index_t p = prev_[v];
+                index_t n = next_[v];
+                remove(v);
+                push(p);
+                push(n);
+                error_ = std::max(error_, cost);
+            }
+            return (nb_distinct_ <= max_nb_points);
+        }
+
+    protected:
+
+        /**
+         * \brief Initializes the data structures used by simplify()
+         * \details Consecutive duplicated points are merged, then all
+         *  the other points are inserted in the priority queue.
+         */
+        void init() {
+            index_t nv = index_t(x_.size());
+            alive_.assign(nv, true);
+            next_.resize(nv);
+            prev_.resize(nv);
+            polyline_.resize(nv);
+            stamp_.assign(nv,0);
+            covered_.assign(nv,std::vector<index_t>());
+            polyline_size_.resize(nb_polylines());
+            pixel_count_.assign(256*256,0);
+            nb_distinct_ = 0;
+            error_ = 0.0;
+            for(index_t p=0; p<nb_polylines(); ++p) {
+                index_t b = polyline_first_[p];
+                index_t e = polyline_end(p);
+                polyline_size_[p] = e-b;
+                for(index_t v=b; v<e; ++v) {
+                    polyline_[v] = p;
+                    next_[v] = (v+1 == e) ? b : v+1;
+                    prev_[v] = (v == b) ? e-1 : v-1;
+                }
+            }
+            for(index_t v=0; v<nv; ++v) {
+                if(pixel_count_[pixel(v)] == 0) {
+                    ++nb_distinct_;
+                }
+                ++pixel_count_[pixel(v)];
+                grid_[cell(x_[v],y_[v])].push_back(v);
+            }
+            for(index_t v=0; v<nv; ++v) {
+                while(
+                    alive_[v] && polyline_size_[polyline_[v]] > 3 &&
+                    pixel(next_[v]) == pixel(v)
+                ) {
+                    remove(next_[v]);
+                }
+            }
+            for(index_t v=0; v<nv; ++v) {
+                if(alive_[v]) {
+                    push(v);
+                }
+            }
+        }
+
+        /**
+         * \brief Removes a point and updates its neighbors
+         * \param[in] v the point
+         */
+        void remove(index_t v) {
+            index_t p = prev_[v];
+            index_t n = next_[v];
+            alive_[v] = false;
+            next_[p] = n;
+            prev_[n] = p;
+            --polyline_size_[polyline_[v]];
+            covered_[p].push_back(v);
+            covered_[p].insert(
+                covered_[p].end(), covered_[v].begin(), covered_[v].end()
+            );
+            covered_[v].clear();
+            --pixel_count_[pixel(v)];
+            if(pixel_count_[pixel(v)] == 0) {
+                --nb_distinct_;
+            }
+            std::vector<index_t>& C = grid_[cell(x_[v],y_[v])];
+            C.erase(std::find(C.begin(), C.end(), v));
+        }
+
+        /**
+         * \brief Inserts a point in the priority queue, with
+         *  the error introduced by removing it.
+         * \param[in] v the point
+         */
+        void push(index_t v) {
+            index_t p = prev_[v];
+            index_t n = next_[v];
+            double cost = distance(v,p,n);
+            for(index_t w: covered_[p]) {
+                cost = std::max(cost, distance(w,p,n));
+            }
+            for(index_t w: covered_[v]) {
+                cost = std::max(cost, distance(w,p,n));
+            }
+            ++stamp_[v];
+            queue_.push(std::make_pair(cost, std::make_pair(v,stamp_[v])));
+        }
+
+        /**
+         * \brief Tests whether removing a point does not change the
+         *  topology of the polylines.
+         * \param[in] v the point
+         * \retval true if the triangle formed by \p v and its two
+         *  neighbors contains no other point
+         * \retval false otherwise
+         */
+        bool can_remove(index_t v) const {
+            index_t p = prev_[v];
+            index_t n = next_[v];
+            int xmin = std::min(x_[p], std::min(x_[v], x_[n]));
+            int ymin = std::min(y_[p], std::min(y_[v], y_[n]));
+            int xmax = std::max(x_[p], std::max(x_[v], x_[n]));
+            int ymax = std::max(y_[p], std::max(y_[v], y_[n]));
+            Sign s = orient(p,v,n);
+            for(int X=(xmin >> 4); X<=(xmax >> 4); ++X) {
+                for(int Y=(ymin >> 4); Y<=(ymax >> 4); ++Y) {
+                    for(index_t w: grid_[cell(X << 4, Y << 4)]) {
+                        if(
+                            x_[w] < xmin || x_[w] > xmax ||
+                            y_[w] < ymin || y_[w] > ymax ||
+                            pixel(w) == pixel(p) ||
+                            pixel(w) == pixel(v) ||
+                            pixel(w) == pixel(n)
+                        ) {
+                            continue;
+                        }
+                        if(s == ZERO) {
+                            // Degenerate triangle: w is on its bbox
+                            if(orient(p,n,w) == ZERO) {
+                                return false;
+                            }
+                            continue;
+                        }
+                        if(
+                            orient(p,v,w) != -s &&
+                            orient(v,n,w) != -s &&
+                            orient(n,p,w) != -s
+                        ) {
+                            return false;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        /**
+         * \brief Computes the distance between a point and a segment
+         * \param[in] w the point
+         * \param[in] p , n the extremities of the segment
+         */
+        double distance(index_t w, index_t p, index_t n) const {
+            double ux = double(x_[n] - x_[p]);
+            double uy = double(y_[n] - y_[p]);
+            double wx = double(x_[w] - x_[p]);
+            double wy = double(y_[w] - y_[p]);
+            double l2 = ux*ux + uy*uy;
+            double dot = ux*wx + uy*wy;
+            if(dot > 0.0 && dot < l2) {
+                return ::fabs(ux*wy - uy*wx) / ::sqrt(l2);
+            }
+            if(dot >= l2) {
+                wx -= ux;
+                wy -= uy;
+            }
+            return ::sqrt(wx*wx + wy*wy);
+        }
+
+        /**
+         * \brief Computes the orientation of three points
+         */
+        Sign orient(index_t a, index_t b, index_t c) const {
+            Numeric::int64 d =
+                Numeric::int64(x_[b]-x_[a])*Numeric::int64(y_[c]-y_[a]) -
+                Numeric::int64(y_[b]-y_[a])*Numeric::int64(x_[c]-x_[a]);
+            return (d > 0) ? POSITIVE : ((d < 0) ? NEGATIVE : ZERO);
+        }
+        
+        index_t polyline_end(index_t p) const {
+            return (p+1 == nb_polylines()) ?
+                index_t(x_.size()) : polyline_first_[p+1];
+        }
+
+        index_t pixel(index_t v) const {
+            return index_t(y_[v]*256 + x_[v]);
+        }
+
+        static index_t cell(int x, int y) {
+            return index_t((y >> 4)*16 + (x >> 4));
+        }
+        
+    private:
+        std::vector<int> x_;
+        std::vector<int> y_;
+        std::vector<index_t> polyline_first_;
+
+        std::vector<bool> alive_;
+        std::vector<index_t> next_;
+        std::vector<index_t> prev_;
+        std::vector<index_t> polyline_;
+        std::vector<index_t> polyline_size_;
+        std::vector<index_t> stamp_;
+        std::vector<std::vector<index_t> > covered_;
+        std::vector<index_t> pixel_count_;
+        std::vector<index_t> grid_[256];
+        index_t nb_distinct_ = 0;
+        double error_ = 0.0;
+
+        index_t nb_pruned_duplicated_ = 0;
+        index_t nb_pruned_collinear_ = 0;
+        index_t nb_pruned_degenerate_ = 0;
+        index_t nb_pruned_degenerate_points_ = 0;
+        
+        typedef std::pair<double, std::pair<index_t, index_t> > QueueEntry;
+        std::priority_queue<
+            QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>
+        > queue_;
+    };
+
+    /************************************************************************/
+
+    /**
+     * \brief A constrained Delaunay triangulation with integer predicates
+     *  for the points on the grid.
+     * \details The inserted points have integer coordinates, for which
+     *  orient2d() and incircle() are computed exactly with 64 bits
+     *  integers. The predicates that involve a point created by a
+     *  constraints intersection (rational coordinates) use the arithmetic
+     *  expansions of ExactCDT2d. The results are the same as ExactCDT2d,
+     *  including the symbolic perturbation of incircle().
+     */
+    class GridCDT2d : public ExactCDT2d {
+    public:
+        GridCDT2d() : grid_predicates_(true) {
+        }
+
+        /**
+         * \brief Enables or disables integer predicates
+         * \details If disabled, all the predicates use ExactCDT2d
+         *  (for benchmarking).
+         */
+        void set_grid_predicates(bool x) {
+            grid_predicates_ = x;
+        }
+
+        /**
+         * \copydoc ExactCDT2d::clear()
+         */
+        void clear() override {
+            ExactCDT2d::clear();
+            grid_xy_.resize(0);
+        }
+
+    protected:
+        /**
+         * \brief Maximum absolute value of the coordinates handled by
+         *  integer predicates.
+         * \details incircle() computes terms of degree 4 in the
+         *  coordinates, that fit in 64 bits up to 2^12.
+         */
+        static constexpr Numeric::int64 GRID_MAX = 4095;
+
+        /**
+         * \brief Integer coordinates of a point
+         */
+        struct GridPoint {
+            Numeric::int64 x;
+            Numeric::int64 y;
+            bool on_grid;
+        };
+        
+        Sign orient2d(index_t i, index_t j, index_t k) const override {
+            if(grid_predicates_) {
+                GridPoint p0 = grid_point(i);
+                GridPoint p1 = grid_point(j);
+                GridPoint p2 = grid_point(k);
+                if(p0.on_grid && p1.on_grid && p2.on_grid) {
+                    return grid_orient2d(p0,p1,p2);
+                }
+            }
+            return ExactCDT2d::orient2d(i,j,k);
+        }
+
+        /**
+         * \copydoc ExactCDT2d::incircle()
+         * \details Same as PCK::incircle_2d_SOS_with_lengths(), with
+         *  integers.
+         */
+        Sign incircle(
+            index_t i, index_t j, index_t k, index_t l
+        ) const override {
+            if(grid_predicates_) {
+                GridPoint p[4] = {
+                    grid_point(i), grid_point(j), grid_point(k), grid_point(l)
+                };
+                if(
+                    p[0].on_grid && p[1].on_grid &&
+                    p[2].on_grid && p[3].on_grid
+                ) {
+                    return grid_incircle(p);
+                }
+            }
+            return ExactCDT2d::incircle(i,j,k,l);
+        }
+
+        /**
+         * \copydoc ExactCDT2d::rollback_insert_transaction()
+         * \details A duplicated vertex is removed, discard its cached
+         *  integer coordinates.
+         */
+        void rollback_insert_transaction() override {
+            ExactCDT2d::rollback_insert_transaction();
+            if(index_t(grid_xy_.size()) > nv()) {
+                grid_xy_.resize(nv());
+            }
+        }
+
+        /**
+         * \brief Gets the integer coordinates of a vertex
+         * \details The integer coordinates of the vertices are cached.
+         */
+        GridPoint grid_point(index_t v) const {
+            if(v >= nv()) {
+                return compute_grid_point(point_[v]);
+            }
+            while(index_t(grid_xy_.size()) < nv()) {
+                grid_xy_.push_back(
+                    compute_grid_point(point_[index_t(grid_xy_.size())])
+                );
+            }
+            return grid_xy_[v];
+        }
+
+        static GridPoint compute_grid_point(const ExactPoint& p) {
+            GridPoint result;
+            result.x = 0;
+            result.y = 0;
+            result.on_grid =
+                p.w.length() == 1 && p.w.component(0) == 1.0 &&
+                p.x.length() <= 1 && p.y.length() <= 1;
+            if(result.on_grid) {
+                double x = (p.x.length() == 0) ? 0.0 : p.x.component(0);
+                double y = (p.y.length() == 0) ? 0.0 : p.y.component(0);
+                result.on_grid =
+                    x == ::floor(x) && y == ::floor(y) &&
+                    ::fabs(x) <= double(GRID_MAX) &&
+                    ::fabs(y) <= double(GRID_MAX);
+                result.x = Numeric::int64(x);
+                result.y = Numeric::int64(y);
+            }
+            return result;
+        }
+
+        static Sign sign(Numeric::int64 x) {
+            return (x > 0) ? POSITIVE : ((x < 0) ? NEGATIVE : ZERO);
+        }
+        
+        static Sign grid_orient2d(
+            const GridPoint& p0, const GridPoint& p1, const GridPoint& p2
+        ) {
+            return sign(
+                (p1.x-p0.x)*(p2.y-p0.y) - (p1.y-p0.y)*(p2.x-p0.x)
+            );
+        }
+
+        static Sign grid_incircle(const GridPoint* p) {
+            // Lifted coordinates and points relative to p[3]
+            Numeric::int64 l3 = p[3].x*p[3].x + p[3].y*p[3].y;
+            Numeric::int64 L[3];
+            Numeric::int64 X[3];
+            Numeric::int64 Y[3];
+            for(index_t i=0; i<3; ++i) {
+                L[i] = p[i].x*p[i].x + p[i].y*p[i].y - l3;
+                X[i] = p[i].x - p[3].x;
+                Y[i] = p[i].y - p[3].y;
+            }
+            Numeric::int64 M1 = X[1]*Y[2] - Y[1]*X[2];
+            Numeric::int64 M2 = X[0]*Y[2] - Y[0]*X[2];
+            Numeric::int64 M3 = X[0]*Y[1] - Y[0]*X[1];
+            Sign result = sign(L[0]*M1 - L[1]*M2 + L[2]*M3);
+            if(result != ZERO) {
+                return result;
+            }
+            
+            // Symbolic perturbation, the points are considered in
+            // lexicographic order (see PCK::SOS())
+            index_t order[4] = {0, 1, 2, 3};
+            std::sort(
+                order, order+4,
+                [p](index_t a, index_t b)->bool {
+                    return (p[a].x < p[b].x) ||
+                        (p[a].x == p[b].x && p[a].y < p[b].y);
+                }
+            );
+            for(index_t i: order) {
+                switch(i) {
+                case 0:
+                    result = grid_orient2d(p[1],p[2],p[3]);
+                    break;
+                case 1:
+                    result = Sign(-grid_orient2d(p[0],p[2],p[3]));
+                    break;
+                case 2:
+                    result = grid_orient2d(p[0],p[1],p[3]);
+                    break;
+                case 3:
+                    result = Sign(-grid_orient2d(p[0],p[1],p[2]));
+                    break;
+                }
+                if(result != ZERO) {
+                    return result;
+                }
+            }
+            return ZERO;
+        }
+        
+    private:
+        bool grid_predicates_;
+        mutable std::vector<GridPoint> grid_xy_;
+    };
+
+    /************************************************************************/
+
+    class Triangulation : public GridCDT2d {
+    public:
+        Triangulation() :
+            batch_insert_(true),
+            bulk_constraints_(true),
+            classify_border_(false),
+            nb_constraints_swaps_(0) {
+        }
+        
+        index_t insert(double x, double y) {
+            return ExactCDT2d::insert(exact::vec2h(x,y,1.0));
+        }
+
+        /**
+         * \brief Enables or disables batch insertion of the points
+         * \details If enabled, the points of the polylines are inserted
+         *  in spatial sort order, each point being located from the
+         *  previous one. Else they are inserted in the order of the
+         *  polylines, and each point is located from a random triangle.
+         */
+        void set_batch_insert(bool x) {
+            batch_insert_ = x;
+        }
+
+        /**
+         * \brief Enables or disables bulk insertion of the constraints
+         * \details If enabled, the Delaunay condition is restored once
+         *  after all the constraints of the polylines are inserted, else
+         *  it is restored after each constraint.
+         */
+        void set_bulk_constraints(bool x) {
+            bulk_constraints_ = x;
+        }
+
+        /**
+         * \brief Enables or disables the constraints on the border in
+         *  classify()
+         * \details If enabled, the shapes cut by the border of the frame
+         *  are taken into account. Else the triangles on the border are
+         *  considered as outside, as in classify_triangles().
+         */
+        void set_classify_border(bool x) {
+            classify_border_ = x;
+        }
+
+        /**
+         * \brief Inserts a set of constraints
+         * \param[in] vertices the extremities of the constraints
+         */
+        void insert_constraints(const std::vector<index_t>& vertices) {
+            StageProfiler::Timer timer(StageProfiler::CONSTRAINTS);
+            index_t nb_constraints = index_t(vertices.size()/2);
+            Numeric::uint64 nb_swaps_before = nb_swaps();
+            if(bulk_constraints_) {
+                ExactCDT2d::insert_constraints(
+                    nb_constraints, vertices.data(), 1
+                );
+            } else {
+                for(index_t c=0; c<nb_constraints; ++c) {
+                    insert_constraint(vertices[2*c], vertices[2*c+1], 1);
+                }
+            }
+            nb_constraints_swaps_ += nb_swaps() - nb_swaps_before;
+        }
+
+        /**
+         * \brief Gets the number of edge swaps done while inserting
+         *  the constraints
+         */
+        Numeric::uint64 nb_constraints_swaps() const {
+            return nb_constraints_swaps_;
+        }
+
+        /**
+         * \brief Resets the number of edge swaps
+         */
+        void reset_swap_stats() {
+            GridCDT2d::reset_swap_stats();
+            nb_constraints_swaps_ = 0;
+        }
+
+        /**
+         * \brief Inserts a set of points
+         * \param[in] xy the coordinates of the points
+         * \param[out] vertices the vertex of each point
+         */
+        void insert(
+            const std::vector<double>& xy, std::vector<index_t>& vertices
+        ) {
+            StageProfiler::Timer timer(StageProfiler::POINTS);
+            index_t nb_points = index_t(xy.size()/2);
+            vertices.resize(nb_points);
+            if(batch_insert_) {
+                ExactCDT2d::insert(nb_points, xy.data(), vertices.data());
+            } else {
+                for(index_t i=0; i<nb_points; ++i) {
+                    vertices[i] = insert(xy[2*i], xy[2*i+1]);
+                }
+            }
+        }
+        
+        /**
+         * \brief Classifies the triangles as inside or outside the
+         *  polylines.
+         * \details If classify_border is set, the number of constraints
+         *  crossed from the outside of the enclosing rectangle is
+         *  counted. Unlike classify_triangles(), the constraints on the
+         *  border (shapes cut by the border of the frame) are taken into
+         *  account, so that the result does not depend on the order of
+         *  the triangles.
+         */
+        void classify() {
+            StageProfiler::Timer timer(StageProfiler::CLASSIFY);
+            if(!classify_border_) {
+                classify_triangles("union",true); // classify only
+                T_region_.assign(nT(),-1);
+                for(index_t t=0; t<nT(); ++t) {
+                    T_region_[t] = Tflag_is_set(t,T_MARKED_FLAG) ? 1 : 0;
+                    Treset_flag(t, T_MARKED_FLAG);
+                }
+                return;
+            }
+            // Parity of the number of crossed constraints, -1 if not
+            // visited yet.
+            std::vector<index_t> parity(nT(), index_t(-1));
+            std::vector<index_t> S;
+            for(index_t t=0; t<nT(); ++t) {
+                bool on_border = false;
+                index_t t_parity = 0;
+                for(index_t le=0; le<3; ++le) {
+                    if(Tadj(t,le) == index_t(-1)) {
+                        on_border = true;
+                        t_parity ^= edge_cnstr_parity(t,le);
+                    }
+                }
+                if(on_border) {
+                    parity[t] = t_parity;
+                    S.push_back(t);
+                }
+            }
+            while(!S.empty()) {
+                index_t t1 = S.back();
+                S.pop_back();
+                for(index_t le=0; le<3; ++le) {
+                    index_t t2 = Tadj(t1,le);
+                    if(t2 != index_t(-1) && parity[t2] == index_t(-1)) {
+                        parity[t2] = parity[t1] ^ edge_cnstr_parity(t1,le);
+                        S.push_back(t2);
+                    }
+                }
+            }
+            T_region_.assign(nT(),-1);
+            for(index_t t=0; t<nT(); ++t) {
+                T_region_[t] = (parity[t] == 0) ? 1 : 0;
+            }
+        }
+        
+        /**
+         * \copydoc ExactCDT2d::clear()
+         */
+        void clear() override {
+            GridCDT2d::clear();
+            segment_cnstr_.clear();
+            vertex_at_.assign(256*256, index_t(-1));
+        }
+
+        /**
+         * \brief Inserts closed polylines as constraints.
+         * \details The constraints are memorized, so that the
+         *  triangulation can be updated with update_polylines()
+         * \param[in] polylines the polylines
+         */
+        void insert_polylines(const PolylinesSimplifier& polylines) {
+            if(vertex_at_.size() == 0) {
+                vertex_at_.assign(256*256, index_t(-1));
+            }
+            std::vector<int> x;
+            std::vector<int> y;
+
+            // Insert all the points first, or else the points of each
+            // polyline before its constraints
+            std::vector<double> xy;
+            std::vector<index_t> all_vertices;
+            if(batch_insert_) {
+                for(index_t p=0; p<polylines.nb_polylines(); ++p) {
+                    polylines.get_polyline(p,x,y);
+                    for(index_t i=0; i<index_t(x.size()); ++i) {
+                        xy.push_back(double(x[i]));
+                        xy.push_back(double(y[i]));
+                    }
+                }
+                insert(xy, all_vertices);
+            }
+
+            // Then the constraints
+            index_t offset = 0;
+            std::vector<index_t> vertices;
+            std::vector<index_t> cnstr_vertices;
+            for(index_t p=0; p<polylines.nb_polylines(); ++p) {
+                polylines.get_polyline(p,x,y);
+                index_t npoints = index_t(x.size());
+                if(!batch_insert_) {
+                    insert_polyline_points(x, y, vertices);
+                    all_vertices.insert(
+                        all_vertices.end(), vertices.begin(), vertices.end()
+                    );
+                }
+                vertices.resize(0);
+                for(index_t i=0; i<npoints; ++i) {
+                    index_t v = all_vertices[offset+i];
+                    vertex_at_[pixel(x[i],y[i])] = v;
+                    vertices.push_back(v);
+                }
+                offset += npoints;
+                for(index_t i=0; i<npoints; ++i) {
+                    index_t j = (i+1)%npoints;
+                    index_t c = index_t(
+                        constraints_.size() + cnstr_vertices.size()/2
+                    );
+                    cnstr_vertices.push_back(vertices[i]);
+                    cnstr_vertices.push_back(vertices[j]);
+                    if(vertices[i] != vertices[j]) {
+                        segment_cnstr_[
+                            segment(x[i],y[i],x[j],y[j])
+                        ].push_back(c);
+                    }
+                }
+                flush_polyline_constraints(cnstr_vertices);
+            }
+            insert_constraints(cnstr_vertices);
+        }
+
+        /**
+         * \brief Replaces the polylines inserted before with new ones.
+         * \details The constraints that are not in the new polylines are
+         *  removed, as well as the vertices that are no longer used, then
+         *  the new constraints are inserted. Only the constraints that
+         *  changed are removed or inserted, but the segments of all the
+         *  polylines are compared. The triangles are not classified, see
+         *  classify(). The removed vertices keep their index, use
+         *  is_alive() to test them.
+         * \param[in] polylines the new polylines
+         * \retval true on success
+         * \retval false if the polylines could not be updated, that is,
+         *  if the edges of a removed constraint were lost or if a vertex
+         *  that is no longer used could not be removed. Then the
+         *  triangulation is in an undefined state and needs to be cleared.
+         */
+        bool update_polylines(const PolylinesSimplifier& polylines) {
+            if(vertex_at_.size() == 0) {
+                vertex_at_.assign(256*256, index_t(-1));
+            }
+            
+            // Count the segments of the new polylines
+            std::map<Numeric::uint32, index_t> new_count;
+            std::vector<bool> used(256*256, false);
+            std::vector<int> x;
+            std::vector<int> y;
+            for(index_t p=0; p<polylines.nb_polylines(); ++p) {
+                polylines.get_polyline(p,x,y);
+                index_t npoints = index_t(x.size());
+                for(index_t i=0; i<npoints; ++i) {
+                    index_t j = (i+1)%npoints;
+                    used[pixel(x[i],y[i])] = true;
+                    if(x[i] != x[j] || y[i] != y[j]) {
+                        ++new_count[segment(x[i],y[i],x[j],y[j])];
+                    }
+                }
+            }
+
+            // Remove the constraints that disappeared
+            std::vector<index_t> removed;
+            for(auto it = segment_cnstr_.begin(); it != segment_cnstr_.end();) {
+                auto jt = new_count.find(it->first);
+                index_t n = (jt == new_count.end()) ? 0 : jt->second;
+                while(it->second.size() > n) {
+                    removed.push_back(it->second.back());
+                    it->second.pop_back();
+                }
+                if(it->second.size() == 0) {
+                    it = segment_cnstr_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            // While the constraints and the vertices are removed, Tset()
+            // marks the triangles that are modified, and the Delaunay
+            // condition is restored on their edges afterwards.
+            defer_Delaunay_ = delaunay_;
+            std::vector<index_t> candidates;
+            for(index_t c: removed) {
+                if(
+                    !remove_constraint(c, candidates) &&
+                    !remove_constraint_everywhere(c, candidates)
+                ) {
+                    defer_Delaunay_ = false;
+                    return false;
+                }
+            }
+
+            // Remove the vertices that are no longer used
+            index_t nb_removed_vertices = 0;
+            for(index_t v: candidates) {
+                if(v < 4 || !is_alive(v)) { // 4 first: enclosing rectangle
+                    continue;
+                }
+                int vx = get_x(v);
+                int vy = get_y(v);
+                bool on_grid =
+                    (vertex_at_[pixel(vx,vy)] == v);
+                if(on_grid && used[pixel(vx,vy)]) {
+                    continue;
+                }
+                if(!remove_vertex(v) && !remove_vertex_on_segment(v)) {
+                    // Left alone, it would be a vertex of the polygons
+                    // that is not on the polylines
+                    defer_Delaunay_ = false;
+                    return false;
+                }
+                if(on_grid) {
+                    vertex_at_[pixel(vx,vy)] = index_t(-1);
+                }
+                ++nb_removed_vertices;
+            }
+            if(defer_Delaunay_) {
+                defer_Delaunay_ = false;
+                // The removed triangles are not part of the triangulation
+                for(index_t t=0; t<nT(); ++t) {
+                    if(Tflag_is_set(t, T_MARKED_FLAG)) {
+                        Treset_flag(t, T_TOUCHED_FLAG);
+                    }
+                }
+                Delaunayize_touched_triangles();
+            }
+            if(nb_removed_vertices != 0) {
+                remove_marked_triangles();
+            }
+
+            // Insert the new points, or else the points of each
+            // polyline before its constraints
+            if(batch_insert_) {
+                insert_new_points(polylines, 0, polylines.nb_polylines());
+            }
+            
+            // Insert the new constraints
+            std::vector<index_t> vertices;
+            std::vector<index_t> cnstr_vertices;
+            for(index_t p=0; p<polylines.nb_polylines(); ++p) {
+                if(!batch_insert_) {
+                    insert_new_points(polylines, p, p+1);
+                }
+                polylines.get_polyline(p,x,y);
+                index_t npoints = index_t(x.size());
+                vertices.resize(0);
+                for(index_t i=0; i<npoints; ++i) {
+                    vertices.push_back(vertex_at_[pixel(x[i],y[i])]);
+                }
+                for(index_t i=0; i<npoints; ++i) {
+                    index_t j = (i+1)%npoints;
+                    if(vertices[i] == vertices[j]) {
+                        continue;
+                    }
+                    Numeric::uint32 S = segment(x[i],y[i],x[j],y[j]);
+                    std::vector<index_t>& C = segment_cnstr_[S];
+                    if(C.size() < new_count[S]) {
+                        C.push_back(index_t(
+                            constraints_.size() + cnstr_vertices.size()/2
+                        ));
+                        cnstr_vertices.push_back(vertices[i]);
+                        cnstr_vertices.push_back(vertices[j]);
+                    }
+                }
+                flush_polyline_constraints(cnstr_vertices);
+            }
+            insert_constraints(cnstr_vertices);
+            return true;
+        }
+
+        /**
+         * \brief Tests whether a vertex was not removed by 
+         *  update_polylines()
+         */
+        bool is_alive(index_t v) const {
+            return (v2T_[v] != index_t(-1));
+        }
+
+        /**
+         * \brief Gets the number of vertices that were not removed
+         *  by update_polylines()
+         */
+        index_t nb_alive_vertices() const {
+            index_t result = 0;
+            for(index_t v=0; v<nv(); ++v) {
+                result += is_alive(v);
+            }
+            return result;
+        }
+
+        /**
+         * \brief Tests whether the triangulation accumulated too many
+         *  removed vertices and constraints, and should be rebuilt from
+         *  scratch.
+         */
+        bool needs_rebuild() const {
+            index_t nb_cnstr = 0;
+            for(const auto& it: segment_cnstr_) {
+                nb_cnstr += index_t(it.second.size());
+            }
+            return
+                nv() > 2*nb_alive_vertices() + 256 ||
+                constraints_.size() > 2*nb_cnstr + 1024;
+        }
+        
+        int get_x(index_t v) const {
+            double x = point(v).x.estimate();
+            double w = point(v).w.estimate();
+            return int(x/w);
+        }
+        
+        int get_y(index_t v) const {
+            double y = point(v).y.estimate();
+            double w = point(v).w.estimate();
+            return int(y/w);
+        }
+
+        int Tregion(index_t t) const {
+            return T_region_[t];
+        }
+
+        bool Tis_marked(index_t t) {
+            return Tflag_is_set(t,T_MARKED_FLAG);
+        }
+
+        /**
+         * \brief Greedely merge triangles that have the same
+         *  color while they form a convex polygon.
+         */
+        void get_convex_polygon(
+            index_t t, std::vector<GEO::index_t>& P,
+            std::vector<GEO::index_t>* T = nullptr
+        ) {
+            if(T != nullptr) {
+                T->assign(1,t);
+            }
+            P.resize(0);
+            P.push_back(Tv(t,0));
+            P.push_back(Tv(t,1));
+            P.push_back(Tv(t,2));
+            DList S(*this, DLIST_S_ID);
+            Tset_flag(t, T_MARKED_FLAG);
+            S.push_back(t);
+
+            while(!S.empty() && P.size()<15) {
+                index_t t1 = S.front();
+                S.pop_front();
+                for(index_t le1=0; (le1<3 && P.size()<15); ++le1) {
+                    index_t t2 = Tadj(t1,le1);
+
+                    if(t2 == index_t(-1)) {
+                        continue;
+                    }
+
+                if(Tflag_is_set(t2,T_MARKED_FLAG)) {
+                    continue;
+                }
+                
+                if(Tregion(t1) != Tregion(t2)) {
+                    continue;
+                }
+                
+                index_t le2 = Tadj_find(t2,t1);
+                index_t v1 = Tv(t1,(le1+1)%3);
+                index_t v2 = Tv(t1,(le1+2)%3);                
+                index_t v3 = Tv(t2,le2);
+
+                if(false) {
+                    std::cerr << "v1=" << v1
+                              << " v2=" << v2
+                              << " v3=" << v3 << std::endl;
+                    std::cerr << "P=[";
+                    for(index_t i=0; i<P.size(); ++i) {
+                        std::cerr << P[i] << " ";
+                    }
+                    std::cerr << "]" << std::endl;
+                }
+                
+                index_t i1 = index_t(
+                    std::find(P.begin(), P.end(), v1)-P.begin()
+                );
+                assert(i1 < P.size());
+                index_t i2 = index_t(
+                    std::find(P.begin(), P.end(), v2)-P.begin()
+                );
+                assert(i2 < P.size());
+                assert((i1+1)%P.size() == i2);
+
+                index_t i1_prev = (i1+P.size()-1)%P.size();
+                index_t i2_next = (i2+1)%P.size();
+
+                if(
+                    orient2d(P[i1_prev],P[i1],v3) >= 0 &&
+                    orient2d(v3,P[i2],P[i2_next]) >= 0 
+                ) {
+                    Tset_flag(t2,T_MARKED_FLAG);
+                    S.push_back(t2);
+                    P.insert(P.begin()+i2,v3);
+                    if(T != nullptr) {
+                        T->push_back(t2);
+                    }
+                }
+                }
+            }
+        }
+
+        /**
+         * \brief Partitions all the triangles into convex polygons
+         *  using get_convex_polygon().
+         * \param[out] polygons the convex polygons, in the order of
+         *  the triangle they were grown from
+         */
+        void get_convex_polygons_greedy(std::vector<ConvexPolygon>& polygons) {
+            polygons.resize(0);
+            for(index_t t=0; t<nT(); ++t) {
+                if(!Tis_marked(t)) {
+                    polygons.push_back(ConvexPolygon());
+                    polygons.back().color = Tregion(t);
+                    get_convex_polygon(t, polygons.back().vertices);
+                }
+            }
+            for(index_t t=0; t<nT(); ++t) {
+                Treset_flag(t, T_MARKED_FLAG);
+            }
+        }
+
+        /**
+         * \brief Partitions all the triangles into convex polygons
+         *  of at most 15 vertices, trying to minimize their number.
+         * \details Several initial partitions are computed: the one of
+         *  get_convex_polygons_greedy(), the one of Hertel-Mehlhorn
+         *  (merge the pieces across the longest edges first), and
+         *  greedy ones with shuffled seeds. Each of them is then improved
+         *  by a local search, and the one with the smallest number of
+         *  polygons is kept.
+         * \param[out] polygons the convex polygons, in the order of
+         *  their first triangle
+         * \param[in] nb_restarts number of additional greedy partitions
+         *  with shuffled seeds
+         */
+        void get_convex_polygons_optimized(
+            std::vector<ConvexPolygon>& polygons, index_t nb_restarts = 4
+        ) {
+            std::vector<index_t> order(nT());
+            for(index_t t=0; t<nT(); ++t) {
+                order[t] = t;
+            }
+            // Do not use Numeric::random_int32(), it would change the
+            // random walks of locate() in the next frames.
+            Numeric::uint32 seed = 1;
+            index_t best = index_t(-1);
+            for(index_t pass=0; pass<nb_restarts+2; ++pass) {
+                if(pass == 1) {
+                    init_pieces_Hertel_Mehlhorn();
+                } else {
+                    if(pass != 0) {
+                        for(index_t i=nT(); i>1; --i) {
+                            seed = seed*1103515245u + 12345u;
+                            std::swap(order[i-1], order[(seed >> 8)%i]);
+                        }
+                    }
+                    init_pieces_greedy(order);
+                }
+                improve_pieces();
+                index_t nb_pieces = 0;
+                for(const Piece& piece: pieces_) {
+                    nb_pieces += (piece.T.size() != 0);
+                }
+                if(nb_pieces < best) {
+                    best = nb_pieces;
+                    polygons.resize(0);
+                    for(index_t t=0; t<nT(); ++t) {
+                        const Piece& piece = pieces_[T_piece_[t]];
+                        if(piece.T[0] == t) {
+                            polygons.push_back(ConvexPolygon());
+                            polygons.back().color = Tregion(t);
+                            polygons.back().vertices = piece.P;
+                        }
+                    }
+                }
+            }
+        }
+        
+    protected:
+
+        /**
+         * \brief Removes a constraint from all the edges it covers
+         * \details The edges are found by walking along the constraint
+         *  first, so that nothing is removed if the walk fails.
+         * \param[in] c the constraint
+         * \param[in,out] candidates the vertices of the constraint are
+         *  appended here
+         * \retval true on success
+         * \retval false if the edges of the constraint could not be
+         *  found
+         */
+        bool remove_constraint(index_t c, std::vector<index_t>& candidates) {
+            index_t v = constraints_[c].indices[0];
+            index_t j = constraints_[c].indices[1];
+            index_t prev = index_t(-1);
+            std::vector<index_t> path(1,v);
+            std::vector<std::pair<index_t, index_t> > edges;
+            // NASA programming style: all loops have
+            // a maximum number of iterations
+            for(index_t iter=0; v != j; ++iter) {
+                if(iter > nv()) {
+                    return false;
+                }
+                index_t next = index_t(-1);
+                for_each_T_around_v(
+                    v, [&](index_t t, index_t lv)->bool {
+                        for(index_t le: {(lv+1)%3, (lv+2)%3}) {
+                            index_t w = Tv(t,3-lv-le);
+                            if(w != prev && edge_has_cnstr(t,le,c)) {
+                                next = w;
+                                edges.push_back(std::make_pair(t,le));
+                                return true;
+                            }
+                        }
+                        return false;
+                    }
+                );
+                if(next == index_t(-1)) {
+                    return false;
+                }
+                path.push_back(next);
+                prev = v;
+                v = next;
+            }
+            for(const std::pair<index_t, index_t>& e: edges) {
+                remove_edge_cnstr(e.first, e.second, c);
+                touch_unconstrained_edge(e.first, e.second);
+            }
+            candidates.insert(candidates.end(), path.begin(), path.end());
+            return true;
+        }
+
+        /**
+         * \brief Removes a constraint from all the edges of the
+         *  triangulation
+         * \details This is a slower version of remove_constraint(), that
+         *  traverses all the triangles.
+         * \param[in] c the constraint
+         * \param[in,out] candidates the vertices of the constraint are
+         *  appended here
+         * \retval true if the edges of the constraint formed a path
+         *  between its two extremities
+         * \retval false if some of them were lost
+         */
+        bool remove_constraint_everywhere(
+            index_t c, std::vector<index_t>& candidates
+        ) {
+            index_t v1 = constraints_[c].indices[0];
+            index_t v2 = constraints_[c].indices[1];
+            candidates.push_back(v1);
+            candidates.push_back(v2);
+            // Number of edges of the constraint incident to each vertex
+            std::map<index_t, index_t> degree;
+            for(index_t t=0; t<nT(); ++t) {
+                for(index_t le=0; le<3; ++le) {
+                    if(remove_edge_cnstr(t,le,c)) {
+                        index_t w1 = Tv(t,(le+1)%3);
+                        index_t w2 = Tv(t,(le+2)%3);
+                        candidates.push_back(w1);
+                        candidates.push_back(w2);
+                        ++degree[w1];
+                        ++degree[w2];
+                        touch_unconstrained_edge(t,le);
+                    }
+                }
+            }
+            if(degree.size() == 0) {
+                return false;
+            }
+            for(const std::pair<const index_t, index_t>& d: degree) {
+                index_t expected = (d.first == v1 || d.first == v2) ? 1 : 2;
+                if(d.second != expected) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * \brief Tests whether a constraint is in the list of an edge
+         */
+        bool edge_has_cnstr(index_t t, index_t le, index_t c) const {
+            for(
+                index_t ecit = Tedge_cnstr_first(t,le);
+                ecit != index_t(-1);
+                ecit = edge_cnstr_next(ecit)
+            ) {
+                if(edge_cnstr(ecit) == c) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * \brief Marks a triangle for Delaunayize_touched_triangles() if
+         *  one of its edges is no longer constrained
+         * \details Tset() does not mark the triangles when only the
+         *  constraints of an edge change.
+         */
+        void touch_unconstrained_edge(index_t t, index_t le) {
+            if(defer_Delaunay_ && !Tedge_is_constrained(t,le)) {
+                Tset_flag(t, T_TOUCHED_FLAG);
+            }
+        }
+
+        /**
+         * \brief Removes a constraint from the list of an edge
+         * \param[in] t , le the edge
+         * \param[in] c the constraint
+         * \retval true if the constraint was found and removed
+         * \retval false otherwise
+         */
+        bool remove_edge_cnstr(index_t t, index_t le, index_t c) {
+            index_t prev = index_t(-1);
+            index_t ecit = Tedge_cnstr_first(t,le);
+            while(ecit != index_t(-1) && edge_cnstr(ecit) != c) {
+                prev = ecit;
+                ecit = edge_cnstr_next(ecit);
+            }
+            if(ecit == index_t(-1)) {
+                return false;
+            }
+            if(prev != index_t(-1)) {
+                ecnstr_next_[prev] = ecnstr_next_[ecit];
+                return true;
+            }
+            // The list is shared by the two sides of the edge
+            Tset_edge_cnstr_first(t,le,ecnstr_next_[ecit]);
+            index_t t2 = Tadj(t,le);
+            if(t2 != index_t(-1)) {
+                Tset_edge_cnstr_first(t2,Tadj_find(t2,t),ecnstr_next_[ecit]);
+            }
+            return true;
+        }
+
+        /**
+         * \brief Removes a vertex from the triangulation
+         * \details The vertex is not removed if it is on the border or
+         *  on a constrained edge. Edges are flipped until the vertex has
+         *  three neighbors, then the three triangles are merged. The
+         *  removed triangles are marked, and need to be removed with
+         *  remove_marked_triangles().
+         * \param[in] v the vertex
+         * \retval true if the vertex was removed
+         * \retval false otherwise
+         */
+        bool remove_vertex(index_t v) {
+            std::vector<index_t> fan;
+            bool removable = true;
+            for_each_T_around_v(
+                v, [&](index_t t, index_t lv)->bool {
+                    for(index_t le: {(lv+1)%3, (lv+2)%3}) {
+                        if(
+                            Tadj(t,le) == index_t(-1) ||
+                            Tedge_is_constrained(t,le)
+                        ) {
+                            removable = false;
+                            return true;
+                        }
+                    }
+                    fan.push_back(t);
+                    return false;
+                }
+            );
+            if(!removable) {
+                return false;
+            }
+
+            // Flip the edges incident to v until it has three neighbors.
+            // The triangles of the fan remain in the star of v.
+            std::vector<index_t> cur_fan = fan;
+            while(cur_fan.size() > 3) {
+                bool flipped = false;
+                for(index_t t: cur_fan) {
+                    // Rotate t so that edge 0 is incident to v
+                    Trot(t, (Tv_find(t,v)+2)%3);
+                    if(is_convex_quad(t)) {
+                        swap_edge(t);
+                        flipped = true;
+                        break;
+                    }
+                }
+                if(!flipped) {
+                    break;
+                }
+                cur_fan.resize(0);
+                for_each_T_around_v(
+                    v, [&](index_t t, index_t lv)->bool {
+                        geo_argused(lv);
+                        cur_fan.push_back(t);
+                        return false;
+                    }
+                );
+            }
+
+            if(cur_fan.size() == 4) {
+                // No edge can be flipped if v is on a diagonal of the
+                // quadrilateral formed by its neighbors.
+                index_t link[4];
+                for(index_t i=0; i<4; ++i) {
+                    index_t t = cur_fan[i];
+                    link[i] = Tv(t,(Tv_find(t,v)+1)%3);
+                }
+                // Two consecutive neighbors cannot be aligned with v
+                // (they form a triangle with it).
+                bool collapsed = false;
+                for(index_t i=0; i<3 && !collapsed; ++i) {
+                    for(index_t j=i+1; j<4 && !collapsed; ++j) {
+                        if(orient2d(link[i],v,link[j]) == ZERO) {
+                            collapse_vertex_on_segment(v,link[i],link[j]);
+                            collapsed = true;
+                        }
+                    }
+                }
+            } else if(cur_fan.size() == 3) {
+                index_t t0 = cur_fan[0];
+                Trot(t0, Tv_find(t0,v));
+                index_t t1 = Tadj(t0,1);
+                Trot(t1, Tv_find(t1,v));
+                index_t t2 = Tadj(t1,1);
+                Trot(t2, Tv_find(t2,v));
+                index_t a = Tv(t0,1);
+                index_t b = Tv(t0,2);
+                index_t c = Tv(t1,2);
+                Tset(
+                    t0, a, b, c,
+                    Tadj(t1,0), Tadj(t2,0), Tadj(t0,0),
+                    Tedge_cnstr_first(t1,0),
+                    Tedge_cnstr_first(t2,0),
+                    Tedge_cnstr_first(t0,0)
+                );
+                Tadj_back_connect(t0,0,t1);
+                Tadj_back_connect(t0,1,t2);
+                Tset_flag(t1, T_MARKED_FLAG);
+                Tset_flag(t2, T_MARKED_FLAG);
+                v2T_[v] = index_t(-1);
+            }
+
+            return !is_alive(v);
+        }
+
+        /**
+         * \brief Removes a vertex in the middle of a segment, that is
+         *  constrained or on the border, such as a constraints
+         *  intersection that is no longer needed.
+         * \details The vertex is removed if it has exactly two constrained
+         *  or border edges, aligned and with the same constraints. Edges
+         *  are flipped until the vertex has two neighbors on each side of
+         *  the segment (one for a border segment), then the triangles are
+         *  merged. The removed triangles are marked, and need to be removed
+         *  with remove_marked_triangles().
+         * \param[in] v the vertex
+         * \retval true if the vertex was removed
+         * \retval false otherwise
+         */
+        bool remove_vertex_on_segment(index_t v) {
+            std::vector<index_t> fan;
+            std::vector<index_t> neighbors; // extremities of the segment
+            std::vector<index_t> cnstr[2];
+            bool on_border = false;
+            bool removable = true;
+            for_each_T_around_v(
+                v, [&](index_t t, index_t lv)->bool {
+                    // Interior edges are seen twice, from the two
+                    // triangles, test them from one side only.
+                    for(index_t le: {(lv+2)%3, (lv+1)%3}) {
+                        bool border = (Tadj(t,le) == index_t(-1));
+                        if(
+                            (le == (lv+1)%3 && !border) ||
+                            (!border && !Tedge_is_constrained(t,le))
+                        ) {
+                            continue;
+                        }
+                        on_border = on_border || border;
+                        if(neighbors.size() == 2) {
+                            removable = false;
+                            return true;
+                        }
+                        for(
+                            index_t ecit = Tedge_cnstr_first(t,le);
+                            ecit != index_t(-1);
+                            ecit = edge_cnstr_next(ecit)
+                        ) {
+                            cnstr[neighbors.size()].push_back(
+                                edge_cnstr(ecit)
+                            );
+                        }
+                        neighbors.push_back(Tv(t,3-lv-le));
+                    }
+                    fan.push_back(t);
+                    return false;
+                }
+            );
+            if(!removable || neighbors.size() != 2) {
+                return false;
+            }
+            index_t u = neighbors[0];
+            index_t w = neighbors[1];
+            std::sort(cnstr[0].begin(), cnstr[0].end());
+            std::sort(cnstr[1].begin(), cnstr[1].end());
+            if(cnstr[0] != cnstr[1] || orient2d(u,v,w) != ZERO) {
+                return false;
+            }
+            
+            // Flip the interior unconstrained edges incident to v until
+            // it has four neighbors (three on the border). The triangles
+            // of the fan remain in the star of v.
+            index_t nb_T = on_border ? 2 : 4;
+            std::vector<index_t> cur_fan = fan;
+            while(cur_fan.size() > nb_T) {
+                bool flipped = false;
+                for(index_t t: cur_fan) {
+                    // Rotate t so that edge 0 is incident to v
+                    Trot(t, (Tv_find(t,v)+2)%3);
+                    if(
+                        Tadj(t,0) != index_t(-1) &&
+                        !Tedge_is_constrained(t,0) && is_convex_quad(t)
+                    ) {
+                        swap_edge(t);
+                        flipped = true;
+                        break;
+                    }
+                }
+                if(!flipped) {
+                    break;
+                }
+                cur_fan.resize(0);
+                for_each_T_around_v(
+                    v, [&](index_t t, index_t lv)->bool {
+                        geo_argused(lv);
+                        cur_fan.push_back(t);
+                        return false;
+                    }
+                );
+            }
+
+            if(cur_fan.size() == nb_T) {
+                collapse_vertex_on_segment(v,u,w);
+            }
+
+            return !is_alive(v);
+        }
+
+        /**
+         * \brief Removes a vertex with four neighbors (three on the
+         *  border) that is in the middle of the segment joining two of them
+         * \details Triangles (v,u,a), (v,a,w), (v,w,b), (v,b,u)
+         *  are replaced with (u,a,w) and (w,b,u). Edge (u,w) inherits the
+         *  constraints of edge (v,u). The removed triangles are marked.
+         * \param[in] v the vertex
+         * \param[in] u , w two opposite neighbors of \p v aligned with it
+         */
+        void collapse_vertex_on_segment(index_t v, index_t u, index_t w) {
+            index_t tA1 = index_t(-1);
+            index_t tA2 = index_t(-1);
+            index_t tB1 = index_t(-1);
+            index_t tB2 = index_t(-1);
+            std::vector<index_t> fan;
+            for_each_T_around_v(
+                v, [&](index_t t, index_t lv)->bool {
+                    geo_argused(lv);
+                    fan.push_back(t);
+                    return false;
+                }
+            );
+            for(index_t t: fan) {
+                Trot(t, Tv_find(t,v));
+                if(Tv(t,1) == u) {
+                    tA1 = t;
+                } else if(Tv(t,2) == w) {
+                    tA2 = t;
+                } else if(Tv(t,1) == w) {
+                    tB1 = t;
+                } else {
+                    tB2 = t;
+                }
+            }
+            // On the border, there is a single side, make it side A
+            if(tA1 == index_t(-1)) {
+                std::swap(tA1,tB1);
+                std::swap(tA2,tB2);
+                std::swap(u,w);
+            }
+            index_t a = Tv(tA1,2);
+            index_t cnstr_uw = Tedge_cnstr_first(tA1,2);
+            Tset(
+                tA1, u, a, w,
+                Tadj(tA2,0), tB1, Tadj(tA1,0),
+                Tedge_cnstr_first(tA2,0), cnstr_uw,
+                Tedge_cnstr_first(tA1,0)
+            );
+            Tadj_back_connect(tA1,0,tA2);
+            Tset_flag(tA2, T_MARKED_FLAG);
+            if(tB1 != index_t(-1)) {
+                index_t b = Tv(tB1,2);
+                Tset(
+                    tB1, w, b, u,
+                    Tadj(tB2,0), tA1, Tadj(tB1,0),
+                    Tedge_cnstr_first(tB2,0), cnstr_uw,
+                    Tedge_cnstr_first(tB1,0)
+                );
+                Tadj_back_connect(tB1,0,tB2);
+                Tset_flag(tB2, T_MARKED_FLAG);
+            }
+            v2T_[v] = index_t(-1);
+        }
+
+        /**
+         * \brief Inserts the points of a polyline one by one
+         * \details Used when batch insertion is disabled
+         * \param[in] x , y the coordinates of the points
+         * \param[out] vertices the vertex of each point
+         */
+        void insert_polyline_points(
+            const std::vector<int>& x, const std::vector<int>& y,
+            std::vector<index_t>& vertices
+        ) {
+            std::vector<double> xy;
+            for(index_t i=0; i<index_t(x.size()); ++i) {
+                xy.push_back(double(x[i]));
+                xy.push_back(double(y[i]));
+            }
+            insert(xy, vertices);
+        }
+
+        /**
+         * \brief Inserts the points of a range of polylines that do not
+         *  have a vertex yet
+         * \param[in] polylines the polylines
+         * \param[in] begin , end the range of polylines
+         */
+        void insert_new_points(
+            const PolylinesSimplifier& polylines, index_t begin, index_t end
+        ) {
+            std::vector<int> x;
+            std::vector<int> y;
+            std::vector<double> xy;
+            std::vector<index_t> new_pixels;
+            for(index_t p=begin; p<end; ++p) {
+                polylines.get_polyline(p,x,y);
+                for(index_t i=0; i<index_t(x.size()); ++i) {
+                    index_t P = pixel(x[i],y[i]);
+                    if(vertex_at_[P] == index_t(-1)) {
+                        vertex_at_[P] = index_t(-2); // inserted below
+                        xy.push_back(double(x[i]));
+                        xy.push_back(double(y[i]));
+                        new_pixels.push_back(P);
+                    }
+                }
+            }
+            std::vector<index_t> new_vertices;
+            insert(xy, new_vertices);
+            for(index_t i=0; i<index_t(new_pixels.size()); ++i) {
+                vertex_at_[new_pixels[i]] = new_vertices[i];
+            }
+        }
+
+        /**
+         * \brief Inserts the constraints of a polyline right away if
+         *  neither batch insertion nor bulk constraints are used
+         * \details Then the points and the constraints are inserted
+         *  polyline by polyline, as they were before batch insertion.
+         * \param[in,out] cnstr_vertices the extremities of the pending
+         *  constraints, cleared if they are inserted
+         */
+        void flush_polyline_constraints(std::vector<index_t>& cnstr_vertices) {
+            if(!batch_insert_ && !bulk_constraints_) {
+                insert_constraints(cnstr_vertices);
+                cnstr_vertices.resize(0);
+            }
+        }
+
+        /**
+         * \brief Gets the parity of the number of constraints on an edge
+         */
+        index_t edge_cnstr_parity(index_t t, index_t le) const {
+            index_t result = 0;
+            for(
+                index_t ecit = Tedge_cnstr_first(t,le);
+                ecit != index_t(-1);
+                ecit = edge_cnstr_next(ecit)
+            ) {
+                result ^= 1;
+            }
+            return result;
+        }
+
+        static index_t pixel(int x, int y) {
+            return index_t(y*256 + x);
+        }
+
+        /**
+         * \brief Gets a key that identifies a segment, independently
+         *  of its orientation.
+         */
+        static Numeric::uint32 segment(int x1, int y1, int x2, int y2) {
+            Numeric::uint32 p1 = Numeric::uint32(pixel(x1,y1));
+            Numeric::uint32 p2 = Numeric::uint32(pixel(x2,y2));
+            return (std::min(p1,p2) << 16) | std::max(p1,p2);
+        }
+        
+        /**
+         * \brief A set of triangles of the same color that form
+         *  a convex polygon.
+         * \details The first triangle of T is the one with the
+         *  smallest index.
+         */
+        struct Piece {
+            std::vector<index_t> P; // the vertices of the polygon
+            std::vector<index_t> T; // the triangles, empty if merged
+        };
+
+        /**
+         * \brief Initializes the pieces with the polygons
+         *  of get_convex_polygon().
+         * \param[in] order the order in which triangles are used as
+         *  seeds
+         */
+        void init_pieces_greedy(const std::vector<index_t>& order) {
+            pieces_.assign(nT(), Piece());
+            T_piece_.assign(nT(), index_t(-1));
+            for(index_t t: order) {
+                if(!Tis_marked(t)) {
+                    Piece& piece = pieces_[t];
+                    get_convex_polygon(t, piece.P, &piece.T);
+                    std::swap(
+                        piece.T[0],
+                        *std::min_element(piece.T.begin(), piece.T.end())
+                    );
+                    for(index_t t2: piece.T) {
+                        T_piece_[t2] = t;
+                    }
+                }
+            }
+            for(index_t t=0; t<nT(); ++t) {
+                Treset_flag(t, T_MARKED_FLAG);
+            }
+        }
+
+        /**
+         * \brief Initializes the pieces with the triangles, then
+         *  removes the edges that separate two triangles of the same
+         *  color, longest first, whenever the merged polygon stays
+         *  convex (Hertel-Mehlhorn).
+         */
+        void init_pieces_Hertel_Mehlhorn() {
+            pieces_.resize(nT());
+            T_piece_.resize(nT());
+            for(index_t t=0; t<nT(); ++t) {
+                Piece& piece = pieces_[t];
+                piece.P.resize(3);
+                piece.P[0] = Tv(t,0);
+                piece.P[1] = Tv(t,1);
+                piece.P[2] = Tv(t,2);
+                piece.T.assign(1,t);
+                T_piece_[t] = t;
+            }
+
+            std::vector<std::pair<double, index_t> > edges;
+            for(index_t t1=0; t1<nT(); ++t1) {
+                for(index_t le1=0; le1<3; ++le1) {
+                    index_t t2 = Tadj(t1,le1);
+                    if(t2 == index_t(-1) || t2 < t1) {
+                        continue;
+                    }
+                    if(Tregion(t1) != Tregion(t2)) {
+                        continue;
+                    }
+                    double dx = double(
+                        get_x(Tv(t1,(le1+1)%3)) - get_x(Tv(t1,(le1+2)%3))
+                    );
+                    double dy = double(
+                        get_y(Tv(t1,(le1+1)%3)) - get_y(Tv(t1,(le1+2)%3))
+                    );
+                    edges.push_back(std::make_pair(-(dx*dx+dy*dy), 3*t1+le1));
+                }
+            }
+            std::stable_sort(edges.begin(), edges.end());
+            std::vector<index_t> merged;
+            for(const auto& E: edges) {
+                index_t t1 = E.second/3;
+                index_t le1 = E.second%3;
+                index_t p1 = T_piece_[t1];
+                index_t p2 = T_piece_[Tadj(t1,le1)];
+                if(p1 == p2) {
+                    continue;
+                }
+                if(
+                    merge_convex_polygons(
+                        pieces_[p1].P, pieces_[p2].P,
+                        Tv(t1,(le1+1)%3), Tv(t1,(le1+2)%3),
+                        merged
+                    )
+                ) {
+                    merge_pieces(p1, p2, merged);
+                }
+            }
+        }
+
+        /**
+         * \brief Local improvement of the pieces.
+         * \details First tries to dissolve each piece, smallest ones
+         *  first, then tries to repartition the neighborhood of each
+         *  piece with fewer pieces, until there is no improvement.
+         */
+        void improve_pieces() {
+            std::vector<std::pair<index_t, index_t> > candidates;
+            for(index_t p=0; p<pieces_.size(); ++p) {
+                if(pieces_[p].T.size() != 0) {
+                    candidates.push_back(
+                        std::make_pair(index_t(pieces_[p].T.size()), p)
+                    );
+                }
+            }
+            std::stable_sort(candidates.begin(), candidates.end());
+            for(const auto& C: candidates) {
+                if(pieces_[C.second].T.size() != 0) {
+                    dissolve_piece(C.second);
+                }
+            }
+            // NASA programming style: all loops have
+            // a maximum number of iterations
+            for(index_t iter=0; iter<3; ++iter) {
+                bool improved = false;
+                for(index_t p=0; p<pieces_.size(); ++p) {
+                    if(pieces_[p].T.size() != 0) {
+                        improved = repartition_neighborhood(p) || improved;
+                    }
+                }
+                if(!improved) {
+                    break;
+                }
+            }
+        }
+        
+        /**
+         * \brief Computes the union of two convex polygons that share
+         *  an edge, and tests whether it is a convex polygon with
+         *  at most 15 vertices.
+         * \details If the polygons share more than edge [v1,v2] (a chain
+         *  of aligned edges), then the vertices inside the chain are
+         *  removed.
+         * \param[in] P1 , P2 the two polygons. Edge (v1,v2) is an edge
+         *  of P1 and (v2,v1) an edge of P2.
+         * \param[out] P the union of P1 and P2
+         * \retval true if P is convex and has at most 15 vertices
+         * \retval false otherwise
+         */
+        bool merge_convex_polygons(
+            const std::vector<index_t>& P1, const std::vector<index_t>& P2,
+            index_t v1, index_t v2, std::vector<index_t>& P
+        ) const {
+            index_t n1 = index_t(P1.size());
+            index_t n2 = index_t(P2.size());
+            index_t a1 =
+                index_t(std::find(P1.begin(), P1.end(), v1) - P1.begin());
+            index_t a2 =
+                index_t(std::find(P2.begin(), P2.end(), v1) - P2.begin());
+            geo_argused(v2);
+            geo_debug_assert(a1 < n1 && a2 < n2);
+            index_t b1 = (a1+1)%n1;
+            index_t b2 = (a2+n2-1)%n2;
+            geo_debug_assert(P1[b1] == v2 && P2[b2] == v2);
+            index_t nb_shared = 2;
+
+            // Extend the shared chain on both sides
+            while(
+                nb_shared < n1 && nb_shared < n2 &&
+                P1[(b1+1)%n1] == P2[(b2+n2-1)%n2]
+            ) {
+                b1 = (b1+1)%n1;
+                b2 = (b2+n2-1)%n2;
+                ++nb_shared;
+            }
+            while(
+                nb_shared < n1 && nb_shared < n2 &&
+                P1[(a1+n1-1)%n1] == P2[(a2+1)%n2]
+            ) {
+                a1 = (a1+n1-1)%n1;
+                a2 = (a2+1)%n2;
+                ++nb_shared;
+            }
+            if(
+                nb_shared >= n1 || nb_shared >= n2 ||
+                n1+n2+2-2*nb_shared > 15
+            ) {
+                return false;
+            }
+
+            // Convexity test at both extremities of the chain
+            if(
+                orient2d(P1[(a1+n1-1)%n1], P1[a1], P2[(a2+1)%n2]) < 0 ||
+                orient2d(P2[(b2+n2-1)%n2], P1[b1], P1[(b1+1)%n1]) < 0
+            ) {
+                return false;
+            }
+
+            P.resize(0);
+            for(index_t i=b1; i!=a1; i=(i+1)%n1) {
+                P.push_back(P1[i]);
+            }
+            P.push_back(P1[a1]);
+            for(index_t i=(a2+1)%n2; i!=b2; i=(i+1)%n2) {
+                P.push_back(P2[i]);
+            }
+            return true;
+        }
+
+        /**
+         * \brief Merges two pieces.
+         * \param[in] p1 , p2 the two pieces
+         * \param[in,out] P on entry, the vertices of the merged polygon.
+         *  On exit, garbage.
+         */
+        void merge_pieces(index_t p1, index_t p2, std::vector<index_t>& P) {
+            if(pieces_[p1].T.size() < pieces_[p2].T.size()) {
+                std::swap(p1,p2);
+            }
+            Piece& piece1 = pieces_[p1];
+            Piece& piece2 = pieces_[p2];
+            for(index_t t: piece2.T) {
+                T_piece_[t] = p1;
+            }
+            piece1.T.insert(piece1.T.end(), piece2.T.begin(), piece2.T.end());
+            std::swap(
+                piece1.T[0],
+                *std::min_element(piece1.T.begin(), piece1.T.end())
+            );
+            piece2.T.resize(0);
+            piece2.P.resize(0);
+            std::swap(piece1.P, P);
+        }
+
+        /**
+         * \brief Tries to distribute all the triangles of a piece
+         *  among the neighboring pieces, while keeping them convex.
+         * \details The piece is left unchanged if some of its triangles
+         *  cannot be given to a neighbor.
+         * \param[in] p the piece
+         * \retval true if the piece was dissolved
+         * \retval false otherwise
+         */
+        bool dissolve_piece(index_t p) {
+            std::map<index_t, std::vector<index_t> > new_P;
+            std::map<index_t, index_t> new_T_piece;
+            std::vector<index_t> remaining = pieces_[p].T;
+            std::vector<index_t> P;
+            std::vector<index_t> merged;
+            bool progress = true;
+            while(progress && remaining.size() != 0) {
+                progress = false;
+                for(index_t i=0; i<remaining.size(); ++i) {
+                    index_t t = remaining[i];
+                    for(index_t le=0; le<3; ++le) {
+                        index_t t2 = Tadj(t,le);
+                        if(t2 == index_t(-1) || Tregion(t2) != Tregion(t)) {
+                            continue;
+                        }
+                        auto it = new_T_piece.find(t2);
+                        index_t q = (it == new_T_piece.end()) ?
+                            T_piece_[t2] : it->second;
+                        if(q == p) {
+                            continue;
+                        }
+                        auto jt = new_P.find(q);
+                        const std::vector<index_t>& Q =
+                            (jt == new_P.end()) ? pieces_[q].P : jt->second;
+                        P.resize(3);
+                        P[0] = Tv(t,0);
+                        P[1] = Tv(t,1);
+                        P[2] = Tv(t,2);
+                        if(
+                            merge_convex_polygons(
+                                P, Q, Tv(t,(le+1)%3), Tv(t,(le+2)%3), merged
+                            )
+                        ) {
+                            new_P[q] = merged;
+                            new_T_piece[t] = q;
+                            remaining[i] = remaining.back();
+                            remaining.pop_back();
+                            --i;
+                            progress = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            if(remaining.size() != 0) {
+                return false;
+            }
+            for(auto& it: new_P) {
+                std::swap(pieces_[it.first].P, it.second);
+            }
+            for(const auto& it: new_T_piece) {
+                index_t t = it.first;
+                index_t q = it.second;
+                T_piece_[t] = q;
+                pieces_[q].T.push_back(t);
+                if(t < pieces_[q].T[0]) {
+                    std::swap(pieces_[q].T[0], pieces_[q].T.back());
+                }
+            }
+            pieces_[p].T.resize(0);
+            pieces_[p].P.resize(0);
+            return true;
+        }
+
+        /**
+         * \brief Tries to repartition a piece and its neighbors with
+         *  a smaller number of pieces.
+         * \details The union of the pieces is greedily partitioned again,
+         *  starting from each triangle of the piece as a seed.
+         * \param[in] p the piece
+         * \retval true if the number of pieces was reduced
+         * \retval false otherwise
+         */
+        bool repartition_neighborhood(index_t p) {
+            // Gather p and its neighbors of the same color
+            std::vector<index_t> neighbors(1,p);
+            for(index_t t: pieces_[p].T) {
+                for(index_t le=0; le<3; ++le) {
+                    index_t t2 = Tadj(t,le);
+                    if(t2 == index_t(-1) || Tregion(t2) != Tregion(t)) {
+                        continue;
+                    }
+                    index_t q = T_piece_[t2];
+                    if(
+                        std::find(neighbors.begin(), neighbors.end(), q) ==
+                        neighbors.end()
+                    ) {
+                        neighbors.push_back(q);
+                    }
+                }
+            }
+            if(neighbors.size() < 2) {
+                return false;
+            }
+            std::vector<index_t> U;
+            for(index_t q: neighbors) {
+                U.insert(U.end(), pieces_[q].T.begin(), pieces_[q].T.end());
+            }
+            std::sort(U.begin(), U.end());
+
+            // T_stamp_[t] == stamp_ if t is in U and not used yet
+            if(T_stamp_.size() != nT()) {
+                T_stamp_.assign(nT(), 0);
+            }
+            
+            std::vector<Piece> best_pieces;
+            std::vector<Piece> cur_pieces;
+            std::vector<index_t> merged;
+            std::vector<index_t> P(3);
+            for(index_t seed: pieces_[p].T) {
+                stamp_ += 2;
+                for(index_t t: U) {
+                    T_stamp_[t] = stamp_;
+                }
+                cur_pieces.resize(0);
+                bool worse = false;
+                for(index_t i=0; i<=U.size() && !worse; ++i) {
+                    index_t t = (i == 0) ? seed : U[i-1];
+                    if(T_stamp_[t] != stamp_) {
+                        continue;
+                    }
+                    if(cur_pieces.size()+1 >= neighbors.size()) {
+                        worse = true;
+                        break;
+                    }
+                    cur_pieces.push_back(Piece());
+                    Piece& piece = cur_pieces.back();
+                    piece.P.resize(3);
+                    piece.P[0] = Tv(t,0);
+                    piece.P[1] = Tv(t,1);
+                    piece.P[2] = Tv(t,2);
+                    piece.T.assign(1,t);
+                    T_stamp_[t] = stamp_+1;
+                    // Grow the piece, breadth-first
+                    for(
+                        index_t h=0; h<piece.T.size() && piece.P.size()<15; ++h
+                    ) {
+                        index_t t1 = piece.T[h];
+                        for(index_t le1=0; le1<3; ++le1) {
+                            index_t t2 = Tadj(t1,le1);
+                            if(t2 == index_t(-1) || T_stamp_[t2] != stamp_) {
+                                continue;
+                            }
+                            index_t le2 = Tadj_find(t2,t1);
+                            P[0] = Tv(t2,le2);
+                            P[1] = Tv(t2,(le2+1)%3);
+                            P[2] = Tv(t2,(le2+2)%3);
+                            if(
+                                merge_convex_polygons(
+                                    P, piece.P, P[1], P[2], merged
+                                )
+                            ) {
+                                std::swap(piece.P, merged);
+                                piece.T.push_back(t2);
+                                T_stamp_[t2] = stamp_+1;
+                            }
+                        }
+                    }
+                }
+                if(
+                    !worse && (
+                        best_pieces.size() == 0 ||
+                        cur_pieces.size() < best_pieces.size()
+                    )
+                ) {
+                    std::swap(best_pieces, cur_pieces);
+                }
+            }
+            if(best_pieces.size() == 0) {
+                return false;
+            }
+
+            // Recycle the indices of the pieces
+            for(index_t i=0; i<neighbors.size(); ++i) {
+                Piece& piece = pieces_[neighbors[i]];
+                if(i < best_pieces.size()) {
+                    std::swap(piece, best_pieces[i]);
+                    std::swap(
+                        piece.T[0],
+                        *std::min_element(piece.T.begin(), piece.T.end())
+                    );
+                    for(index_t t: piece.T) {
+                        T_piece_[t] = neighbors[i];
+                    }
+                } else {
+                    piece.T.resize(0);
+                    piece.P.resize(0);
+                }
+            }
+            return true;
+        }
+        
+    private:
+        bool batch_insert_;
+        bool bulk_constraints_;
+        bool classify_border_;
+        Numeric::uint64 nb_constraints_swaps_;
+        std::map<Numeric::uint32, std::vector<index_t> > segment_cnstr_;
+        std::vector<index_t> vertex_at_;
+        vector<int> T_region_;
+        std::vector<Piece> pieces_;
+        std::vector<index_t> T_piece_;
+        std::vector<index_t> T_stamp_;
+        index_t stamp_ = 0;
+    };
+
+    /**
+     * \brief Encodes the frames that only move the points of the
+     *  polylines of a keyframe as new vertex tables.
+     * \details The polylines of a new frame are matched with the ones of
+     *  the keyframe: each one with a polyline of the same size, with a
+     *  cyclic shift of its points, such that no point moves more than a
+     *  given distance. The vertices of the triangulation of the keyframe
+     *  are moved with the points of the polylines, and the motion is
+     *  accepted if the vertices on the border of the screen slide along
+     *  it, and if all the polygons stay convex with the same
+     *  orientation, at the new positions and all along the way (players
+     *  may interpolate the vertex tables).
+     */
+    class MotionEncoder {
+    public:
+
+        /**
+         * \brief MotionEncoder constructor
+         */
+        MotionEncoder() : valid_(false) {
+        }
+
+        /**
+         * \brief Tests whether frames can be encoded as motion frames
+         */
+        bool valid() const {
+            return valid_;
+        }
+
+        /**
+         * \brief Forgets the keyframe
+         */
+        void clear() {
+            valid_ = false;
+        }
+
+        /**
+         * \brief Tests whether the keyframe was cleared
+         */
+        bool clear_bit() const {
+            return clear_;
+        }
+
+        /**
+         * \brief Sets the keyframe
+         * \details The keyframe cannot be used if some vertices of the
+         *  polygons are not points of the polylines or corners of the
+         *  screen (intersections).
+         * \param[in] triangulation the triangulation of the keyframe
+         * \param[in] polygons all the convex polygons, including the
+         *  ones that were not written
+         * \param[in] polylines the polylines of the keyframe
+         * \param[in] table the triangulation vertices in the order of the
+         *  vertex table of the keyframe, or empty if the keyframe is not
+         *  indexed
+         * \param[in] clear whether the keyframe was cleared
+         */
+        void set_keyframe(
+            const Triangulation& triangulation,
+            const std::vector<ConvexPolygon>& polygons,
+            const PolylinesSimplifier& polylines,
+            const std::vector<index_t>& table,
+            bool clear
+        ) {
+            valid_ = false;
+            clear_ = clear;
+            x_.resize(0);
+            y_.resize(0);
+            fixed_.resize(0);
+            polygons_.resize(0);
+            table_.resize(0);
+            polylines_.resize(0);
+            if(table.size() == 0) {
+                return;
+            }
+
+            // Local indices of the vertices of the polygons
+            std::vector<index_t> local(triangulation.nv(), index_t(-1));
+            std::vector<index_t> pixel_vertex(256*256, index_t(-1));
+            for(const ConvexPolygon& P: polygons) {
+                polygons_.push_back(std::vector<index_t>());
+                for(index_t v: P.vertices) {
+                    if(local[v] == index_t(-1)) {
+                        local[v] = index_t(x_.size());
+                        int x = triangulation.get_x(v);
+                        int y = triangulation.get_y(v);
+                        x_.push_back(x);
+                        y_.push_back(y);
+                        fixed_.push_back(
+                            (x == 0 || x == 255) && (y == 0 || y == 255)
+                        );
+                        pixel_vertex[pixel(x,y)] = local[v];
+                    }
+                    polygons_.back().push_back(local[v]);
+                }
+            }
+            for(index_t v: table) {
+                if(local[v] == index_t(-1)) {
+                    return;
+                }
+                table_.push_back(local[v]);
+            }
+
+            // Vertex of each point of the polylines
+            std::vector<bool> on_polyline(x_.size(), false);
+            std::vector<int> X;
+            std::vector<int> Y;
+            for(index_t p=0; p<polylines.nb_polylines(); ++p) {
+                polylines.get_polyline(p, X, Y);
+                polylines_.push_back(std::vector<index_t>());
+                for(index_t i=0; i<X.size(); ++i) {
+                    index_t v = pixel_vertex[pixel(X[i],Y[i])];
+                    if(v == index_t(-1)) {
+                        return;
+                    }
+                    on_polyline[v] = true;
+                    polylines_.back().push_back(v);
+                }
+            }
+            for(index_t v=0; v<x_.size(); ++v) {
+                if(!on_polyline[v] && !fixed_[v]) {
+                    return;
+                }
+            }
+            valid_ = true;
+        }
+
+        /**
+         * \brief Moves the vertices of the keyframe to the points of
+         *  new polylines
+         * \details On success, the new positions replace the ones of the
+         *  keyframe, so that the next frames are compared with them.
+         * \param[in] polylines the polylines of the new frame
+         * \param[in] max_distance the maximum distance a point can move
+         * \param[out] X , Y the new vertex table
+         * \retval true if the polylines could be matched, if the
+         *  vertices on the border of the screen stay on it and if the
+         *  polygons stay convex
+         * \retval false otherwise
+         */
+        bool move(
+            const PolylinesSimplifier& polylines, double max_distance,
+            std::vector<uint8_t>& X, std::vector<uint8_t>& Y
+        ) {
+            if(!valid_ || polylines.nb_polylines() != polylines_.size()) {
+                return false;
+            }
+            int max_d2 = int(max_distance * max_distance);
+            std::vector<int> new_x = x_;
+            std::vector<int> new_y = y_;
+            std::vector<bool> moved(x_.size(), false);
+            std::vector<bool> used(polylines_.size(), false);
+            std::vector<int> PX;
+            std::vector<int> PY;
+            for(index_t p=0; p<polylines.nb_polylines(); ++p) {
+                polylines.get_polyline(p, PX, PY);
+                index_t n = index_t(PX.size());
+
+                // Unused key polyline of the same size, with the shift
+                // that minimizes the distance of the first point
+                index_t best = index_t(-1);
+                index_t best_shift = 0;
+                int best_d2 = max_d2 + 1;
+                for(index_t q=0; q<polylines_.size(); ++q) {
+                    if(used[q] || polylines_[q].size() != n) {
+                        continue;
+                    }
+                    for(index_t s=0; s<n; ++s) {
+                        int d2 = dist2(polylines_[q][s], PX[0], PY[0]);
+                        if(d2 < best_d2 && matches(q, s, PX, PY, max_d2)) {
+                            best = q;
+                            best_shift = s;
+                            best_d2 = d2;
+                        }
+                    }
+                }
+                if(best == index_t(-1)) {
+                    return false;
+                }
+                used[best] = true;
+
+                // A vertex shared by several polylines moves with all
+                // of them.
+                for(index_t i=0; i<n; ++i) {
+                    index_t v = polylines_[best][(i + best_shift) % n];
+                    if(moved[v] || fixed_[v]) {
+                        if(new_x[v] != PX[i] || new_y[v] != PY[i]) {
+                            return false;
+                        }
+                    }
+                    new_x[v] = PX[i];
+                    new_y[v] = PY[i];
+                    moved[v] = true;
+                }
+            }
+
+            // Vertices on the border of the screen stay on their border
+            // line, else the polygons would no longer cover the screen.
+            for(index_t v=0; v<x_.size(); ++v) {
+                if(
+                    ((x_[v] == 0 || x_[v] == 255) && new_x[v] != x_[v]) ||
+                    ((y_[v] == 0 || y_[v] == 255) && new_y[v] != y_[v])
+                ) {
+                    return false;
+                }
+            }
+
+            // Convexity, at the new positions and in-between
+            for(const std::vector<index_t>& P: polygons_) {
+                int sign = int(geo_sgn(area2(P, x_, y_)));
+                if(
+                    !convex(P, new_x, new_y, sign) ||
+                    !convex_while_moving(P, new_x, new_y, sign)
+                ) {
+                    return false;
+                }
+            }
+
+            x_.swap(new_x);
+            y_.swap(new_y);
+            X.resize(table_.size());
+            Y.resize(table_.size());
+            for(index_t i=0; i<table_.size(); ++i) {
+                X[i] = uint8_t(x_[table_[i]]);
+                Y[i] = uint8_t(y_[table_[i]]);
+            }
+            return true;
+        }
+
+    protected:
+
+        static index_t pixel(int x, int y) {
+            return index_t(x) | (index_t(y) << 8);
+        }
+
+        int dist2(index_t v, int x, int y) const {
+            return (x_[v]-x)*(x_[v]-x) + (y_[v]-y)*(y_[v]-y);
+        }
+
+        /**
+         * \brief Tests whether the points of a polyline are close to the
+         *  ones of a key polyline
+         * \param[in] q the key polyline
+         * \param[in] shift the point of \p q that corresponds to the
+         *  first point
+         * \param[in] PX , PY the points of the polyline
+         * \param[in] max_d2 the maximum squared distance
+         */
+        bool matches(
+            index_t q, index_t shift,
+            const std::vector<int>& PX, const std::vector<int>& PY,
+            int max_d2
+        ) const {
+            index_t n = index_t(PX.size());
+            for(index_t i=0; i<n; ++i) {
+                index_t v = polylines_[q][(i + shift) % n];
+                if(dist2(v, PX[i], PY[i]) > max_d2) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * \brief Computes twice the signed area of a polygon
+         */
+        static Numeric::int64 area2(
+            const std::vector<index_t>& P,
+            const std::vector<int>& x, const std::vector<int>& y
+        ) {
+            Numeric::int64 result = 0;
+            for(index_t i=0; i<P.size(); ++i) {
+                index_t j = (i+1) % P.size();
+                result += Numeric::int64(x[P[i]]) * Numeric::int64(y[P[j]]) -
+                          Numeric::int64(x[P[j]]) * Numeric::int64(y[P[i]]);
+            }
+            return result;
+        }
+
+        /**
+         * \brief Tests whether a polygon is convex with a given
+         *  orientation
+         * \details Flat corners are accepted, flat polygons are not.
+         */
+        static bool convex(
+            const std::vector<index_t>& P,
+            const std::vector<int>& x, const std::vector<int>& y, int sign
+        ) {
+            if(int(geo_sgn(area2(P,x,y))) != sign) {
+                return false;
+            }
+            index_t n = index_t(P.size());
+            for(index_t i=0; i<n; ++i) {
+                index_t a = P[i];
+                index_t b = P[(i+1)%n];
+                index_t c = P[(i+2)%n];
+                Numeric::int64 o =
+                    Numeric::int64(x[b]-x[a]) * Numeric::int64(y[c]-y[a]) -
+                    Numeric::int64(y[b]-y[a]) * Numeric::int64(x[c]-x[a]);
+                if(int(geo_sgn(o)) == -sign) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * \brief Tests whether a polygon stays convex with a given
+         *  orientation while its vertices move linearly from their
+         *  current position to a new one
+         * \details The orientation of a corner is a quadratic function
+         *  o(t) = At^2 + Bt + C of the interpolation parameter t, with
+         *  integer coefficients, and its minimum over [0,1] is computed
+         *  exactly. Players also round the interpolated coordinates,
+         *  see corner_convex_when_rounded().
+         */
+        bool convex_while_moving(
+            const std::vector<index_t>& P,
+            const std::vector<int>& new_x, const std::vector<int>& new_y,
+            int sign
+        ) const {
+            if(sign == 0) {
+                return false;
+            }
+            index_t n = index_t(P.size());
+            for(index_t i=0; i<n; ++i) {
+                index_t a = P[i];
+                index_t b = P[(i+1)%n];
+                index_t c = P[(i+2)%n];
+
+                // Edge vectors U=b-a and V=c-a and their motions dU, dV
+                Numeric::int64 ux = x_[b]-x_[a];
+                Numeric::int64 uy = y_[b]-y_[a];
+                Numeric::int64 vx = x_[c]-x_[a];
+                Numeric::int64 vy = y_[c]-y_[a];
+                Numeric::int64 dux = (new_x[b]-new_x[a]) - ux;
+                Numeric::int64 duy = (new_y[b]-new_y[a]) - uy;
+                Numeric::int64 dvx = (new_x[c]-new_x[a]) - vx;
+                Numeric::int64 dvy = (new_y[c]-new_y[a]) - vy;
+
+                // sign * o(t), minimum at t=0, t=1, or -B/2A if it is
+                // in between
+                Numeric::int64 A = sign * (dux*dvy - duy*dvx);
+                Numeric::int64 B = sign * (ux*dvy + dux*vy - uy*dvx - duy*vx);
+                Numeric::int64 C = sign * (ux*vy - uy*vx);
+                if(C < 0 || A + B + C < 0) {
+                    return false;
+                }
+                if(A > 0 && B < 0 && -B < 2*A && 4*A*C < B*B) {
+                    return false;
+                }
+
+                if(!corner_convex_when_rounded(a, b, c, new_x, new_y, sign)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * \brief Tests whether a corner of a polygon stays convex when
+         *  players round the interpolated coordinates
+         * \details Players compute p + (q-p)*step/nb_steps with integers.
+         *  A rounded coordinate that moves by d only changes when
+         *  t = step/nb_steps crosses a multiple of 1/|d|, so that testing
+         *  these values of t covers any number of steps.
+         * \param[in] a , b , c the vertices of the corner
+         * \param[in] new_x , new_y the new positions of the vertices
+         * \param[in] sign the orientation of the polygon
+         */
+        bool corner_convex_when_rounded(
+            index_t a, index_t b, index_t c,
+            const std::vector<int>& new_x, const std::vector<int>& new_y,
+            int sign
+        ) const {
+            index_t V[3] = { a, b, c };
+            for(index_t i=0; i<6; ++i) {
+                index_t v = V[i/2];
+                int m = (i%2 == 0) ?
+                    std::abs(new_x[v]-x_[v]) : std::abs(new_y[v]-y_[v]);
+                // t = k/m, t=0 is the current position and t=1 the new
+                // one, both tested by convex()
+                for(int k=1; k<m; ++k) {
+                    int X[3];
+                    int Y[3];
+                    for(index_t j=0; j<3; ++j) {
+                        X[j] = x_[V[j]] + (new_x[V[j]]-x_[V[j]])*k/m;
+                        Y[j] = y_[V[j]] + (new_y[V[j]]-y_[V[j]])*k/m;
+                    }
+                    Numeric::int64 o =
+                        Numeric::int64(X[1]-X[0])*Numeric::int64(Y[2]-Y[0]) -
+                        Numeric::int64(Y[1]-Y[0])*Numeric::int64(X[2]-X[0]);
+                    if(int(geo_sgn(o)) == -sign) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+    private:
+        bool valid_;
+        bool clear_ = false;
+        std::vector<int> x_;
+        std::vector<int> y_;
+        std::vector<bool> fixed_;
+        std::vector<std::vector<index_t> > polygons_;
+        std::vector<index_t> table_;
+        std::vector<std::vector<index_t> > polylines_;
+    };
+
+}
+
+/**
+ * \brief Generates a string of length \p len from integer \p i
+ *  padded with zeroes.
+ */
+std::string to_string(int i, int len);
+
+/**
+ * \brief Loads the polylines of a .fig file
+ * \details The coordinates are scaled from the bounding box of the
+ *  figure to [0,255]x[0,255].
+ *  Reference: https://mcj.sourceforge.net/fig-format.html
+ * \param[in] in the stream to read from
+ * \param[in] filename the name of the file, for error messages
+ * \param[out] polylines the polylines
+ * \return the number of polylines
+ */
+int load_fig(
+    std::istream& in, const std::string& filename,
+    GEO::PolylinesSimplifier& polylines
+);
+
+/**
+ * \brief Sets the options of a triangulation from the command line
+ * \param[out] triangulation the triangulation
+ */
+void configure_triangulation(GEO::Triangulation& triangulation);
+
+/**
+ * \brief Triangulates closed polylines and classifies the triangles.
+ * \details If there are too many vertices for indexed polygons, the
+ *  polylines are simplified and triangulated again.
+ * \param[out] triangulation the triangulation
+ * \param[in,out] polylines the polylines
+ */
+void triangulate_polylines(
+    GEO::Triangulation& triangulation, GEO::PolylinesSimplifier& polylines
+);
+
+/**
+ * \brief Updates the triangulation of the previous frame with the
+ *  polylines of the new frame and classifies the triangles.
+ * \details Only the constraints and the vertices are updated
+ *  incrementally. All the triangles are classified again, and
+ *  polygonize() also processes the whole triangulation, so that the
+ *  cost of these stages remains proportional to the size of the frame.
+ * \param[in,out] triangulation the triangulation
+ * \param[in] polylines the polylines
+ * \retval true on success
+ * \retval false if the triangulation needs to be computed from
+ *  scratch with triangulate_polylines()
+ */
+bool update_triangulation(
+    GEO::Triangulation& triangulation,
+    const GEO::PolylinesSimplifier& polylines
+);
+
+/**
+ * \brief Partitions the triangles into convex polygons
+ * \param[in] triangulation the triangulation, with classified triangles
+ * \param[out] polygons the convex polygons
+ */
+void polygonize(
+    GEO::Triangulation& triangulation,
+    std::vector<GEO::ConvexPolygon>& polygons
+);
+
+/**
+ * \brief Writes a frame to a ST_NICCC file
+ * \details Polygons are indexed if there are less than 255 vertices,
+ *  or with several vertex tables if vertex_banks is set and this is
+ *  smaller than storing the x,y coordinates. Palette entry 0 holds the
+ *  color of the regions tagged with \p palette_background, and entry 1
+ *  the other one.
+ * \param[in] io the ST_NICCC file, or a counter opened with
+ *  st_niccc_open_counter()
+ * \param[in] triangulation the triangulation
+ * \param[in] polygons the convex polygons
+ * \param[in] background the color of the regions that are not
+ *  written, the frame is cleared with it instead, or -1 to write all
+ *  the regions
+ * \param[in] palette_background the color in palette entry 0 before
+ *  this frame. If \p background is different, the palette is swapped.
+ * \param[out] table if non-null, the triangulation vertices in the
+ *  order of the vertex table, or empty if the frame does not have a
+ *  single vertex table (see MotionEncoder)
+ */
+void write_frame(
+    ST_NICCC_IO* io,
+    const GEO::Triangulation& triangulation,
+    const std::vector<GEO::ConvexPolygon>& polygons,
+    int background = -1, int palette_background = 0,
+    std::vector<GEO::index_t>* table = nullptr
+);
+
+/**
+ * \brief Gets the number of bytes of an encoded frame
+ * \param[in] triangulation the triangulation
+ * \param[in] polygons the convex polygons
+ * \param[in] background , palette_background see write_frame()
+ */
+GEO::index_t frame_size(
+    const GEO::Triangulation& triangulation,
+    const std::vector<GEO::ConvexPolygon>& polygons,
+    int background = -1, int palette_background = 0
+);
+
+/**
+ * \brief Chooses the color that is cleared instead of written
+ * \details The frame is encoded with each color as the background, and
+ *  the smallest encoding is kept, including the cost of swapping the
+ *  palette entries.
+ * \param[in] triangulation the triangulation
+ * \param[in] polygons the convex polygons
+ * \param[in] palette_background the color in palette entry 0
+ * \return the color to be passed to write_frame(), or -1 if
+ *  clear_background is not set
+ */
+int choose_background(
+    const GEO::Triangulation& triangulation,
+    const std::vector<GEO::ConvexPolygon>& polygons,
+    int palette_background
+);
+
+/**
+ * \brief Displays the counters of the predicates that were invoked
+ * \param[in] frame if set, displays the counters since the previous
+ *  call with frame set, else since the beginning of the run
+ */
+void print_predicate_stats(bool frame);
+
+/**
+ * \brief Parses a .fig file and appends its frame to a ST_NICCC file
+ * \details The triangulation, the palette and the keyframe are kept
+ *  from one call to the next (incremental updates, hold and motion
+ *  frames).
+ * \param[in] filename the .fig file
+ * \param[in] io the ST_NICCC file
+ * \retval true if the file was read
+ * \retval false otherwise
+ */
+bool fig_2_ST_NICCC(const std::string& filename, ST_NICCC_IO* io);
+
+/**
+ * \brief Writes the first frame of a stream, that sets the palette
+ * \param[in] io the ST_NICCC file
+ */
+void begin_stream(ST_NICCC_IO* io);
+
+/**
+ * \brief Writes the end of a stream
+ * \param[in] io the ST_NICCC file
+ */
+void end_stream(ST_NICCC_IO* io);
+
+/**
+ * \brief Declares the command line arguments of the encoder, used by
+ *  fig_2_ST_NICCC()
+ */
+void declare_encoder_args();
+
+#endif
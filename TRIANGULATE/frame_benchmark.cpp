@@ -0,0 +1,312 @@
+/*
+ * Benchmark of the triangulations over real frames: loads the .fig
+ *  files generated by vectorize.sh once, then times CDT2d, ExactCDT2d
+ *  and the Triangulation of the encoder for vertex insertion,
+ *  constraint insertion, classification and convex merging, with
+ *  warm-up passes and repetitions (see frame_benchmark.sh).
+ * The frames are timed as loaded, then after
+ *  PolylinesSimplifier::prune(), to measure the time saved by removing
+ *  the duplicated and collinear points.
+ */
+
+#include "encoder.h"
+
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+    using namespace GEO;
+
+    /**
+     * \brief The points and the constraints of a frame
+     */
+    struct Frame {
+        std::vector<double> xy;
+        // Pairs of indices in xy, degenerate constraints are skipped
+        std::vector<index_t> constraints;
+    };
+
+    enum Stage {
+        POINTS, CONSTRAINTS, CLASSIFY, CONVEX, NB_STAGES
+    };
+
+    const char* stage_names[NB_STAGES] = {
+        "points", "constraints", "classify", "convex"
+    };
+
+    /**
+     * \brief Loads all the frames of a directory
+     * \param[in] dirname the directory with the frameXXXX.fig files
+     * \param[out] frames the frames
+     * \param[in] prune if set, the duplicated and collinear points and
+     *  the flat polylines are removed
+     * \return the number of points
+     */
+    index_t load_frames(
+        const std::string& dirname, std::vector<Frame>& frames, bool prune
+    ) {
+        index_t nb_points = 0;
+        for(int id=1; ; ++id) {
+            std::string filename =
+                dirname + "/frame" + to_string(id,4) + ".fig";
+            std::ifstream in(filename);
+            if(!in) {
+                break;
+            }
+            PolylinesSimplifier polylines;
+            load_fig(in, filename, polylines);
+            if(prune) {
+                polylines.prune();
+            }
+            frames.push_back(Frame());
+            Frame& F = frames.back();
+            std::vector<int> x;
+            std::vector<int> y;
+            for(index_t p=0; p<polylines.nb_polylines(); ++p) {
+                polylines.get_polyline(p,x,y);
+                index_t offset = index_t(F.xy.size()/2);
+                index_t n = index_t(x.size());
+                for(index_t i=0; i<n; ++i) {
+                    F.xy.push_back(double(x[i]));
+                    F.xy.push_back(double(y[i]));
+                }
+                for(index_t i=0; i<n; ++i) {
+                    index_t j = (i+1)%n;
+                    if(x[i] != x[j] || y[i] != y[j]) {
+                        F.constraints.push_back(offset+i);
+                        F.constraints.push_back(offset+j);
+                    }
+                }
+                nb_points += n;
+            }
+        }
+        return nb_points;
+    }
+
+    /**
+     * \brief Times one pass of CDT2d over all the frames
+     * \param[out] time the time of each stage, in seconds
+     * \return a checksum
+     */
+    index_t run_CDT2d(const std::vector<Frame>& frames, double* time) {
+        static CDT2d cdt;
+        index_t check = 0;
+        std::vector<index_t> vertices;
+        for(const Frame& F : frames) {
+            cdt.clear();
+            cdt.create_enclosing_rectangle(0.0, 0.0, 255.0, 255.0);
+            {
+                WallClock W;
+                vertices.resize(F.xy.size()/2);
+                for(index_t i=0; i<vertices.size(); ++i) {
+                    vertices[i] = cdt.insert(vec2(F.xy[2*i], F.xy[2*i+1]));
+                }
+                time[POINTS] += W.elapsed_time();
+            }
+            {
+                WallClock W;
+                for(index_t c=0; c<F.constraints.size(); c+=2) {
+                    cdt.insert_constraint(
+                        vertices[F.constraints[c]],
+                        vertices[F.constraints[c+1]]
+                    );
+                }
+                time[CONSTRAINTS] += W.elapsed_time();
+            }
+            check += cdt.nT();
+        }
+        return check;
+    }
+
+    /**
+     * \brief Times one pass of ExactCDT2d over all the frames
+     * \param[out] time the time of each stage, in seconds
+     * \return a checksum
+     */
+    index_t run_ExactCDT2d(const std::vector<Frame>& frames, double* time) {
+        static ExactCDT2d cdt;
+        index_t check = 0;
+        std::vector<index_t> vertices;
+        for(const Frame& F : frames) {
+            cdt.clear();
+            cdt.create_enclosing_rectangle(0.0, 0.0, 255.0, 255.0);
+            {
+                WallClock W;
+                vertices.resize(F.xy.size()/2);
+                for(index_t i=0; i<vertices.size(); ++i) {
+                    vertices[i] = cdt.insert(
+                        exact::vec2h(F.xy[2*i], F.xy[2*i+1], 1.0)
+                    );
+                }
+                time[POINTS] += W.elapsed_time();
+            }
+            {
+                WallClock W;
+                for(index_t c=0; c<F.constraints.size(); c+=2) {
+                    cdt.insert_constraint(
+                        vertices[F.constraints[c]],
+                        vertices[F.constraints[c+1]], 1
+                    );
+                }
+                time[CONSTRAINTS] += W.elapsed_time();
+            }
+            {
+                WallClock W;
+                cdt.classify_triangles("A", true);
+                time[CLASSIFY] += W.elapsed_time();
+            }
+            check += cdt.nT();
+        }
+        return check;
+    }
+
+    /**
+     * \brief Times one pass of the Triangulation of the encoder
+     *  (integer predicates, batch insertion, bulk constraints)
+     *  over all the frames
+     * \param[out] time the time of each stage, in seconds
+     * \return a checksum
+     */
+    index_t run_Triangulation(const std::vector<Frame>& frames, double* time) {
+        static Triangulation cdt;
+        index_t check = 0;
+        std::vector<index_t> vertices;
+        std::vector<index_t> constraints;
+        std::vector<ConvexPolygon> polygons;
+        cdt.set_delaunay(true);
+        for(const Frame& F : frames) {
+            cdt.clear();
+            cdt.create_enclosing_rectangle(0.0, 0.0, 255.0, 255.0);
+            {
+                WallClock W;
+                cdt.insert(F.xy, vertices);
+                time[POINTS] += W.elapsed_time();
+            }
+            constraints.resize(F.constraints.size());
+            for(index_t c=0; c<F.constraints.size(); ++c) {
+                constraints[c] = vertices[F.constraints[c]];
+            }
+            {
+                WallClock W;
+                cdt.insert_constraints(constraints);
+                time[CONSTRAINTS] += W.elapsed_time();
+            }
+            {
+                WallClock W;
+                cdt.classify();
+                time[CLASSIFY] += W.elapsed_time();
+            }
+            {
+                WallClock W;
+                cdt.get_convex_polygons_greedy(polygons);
+                time[CONVEX] += W.elapsed_time();
+            }
+            check += cdt.nT() + index_t(polygons.size());
+        }
+        return check;
+    }
+
+    typedef index_t (*BenchmarkFunc)(const std::vector<Frame>&, double*);
+
+    /**
+     * \brief Runs the warm-up passes then the timed passes of a
+     *  triangulation and displays mean, standard deviation and
+     *  minimum of each stage
+     */
+    void benchmark(
+        const char* name, BenchmarkFunc func,
+        const std::vector<Frame>& frames,
+        index_t nb_warmup, index_t nb_repeat,
+        bool has_classify, bool has_convex
+    ) {
+        index_t check = 0;
+        for(index_t r=0; r<nb_warmup; ++r) {
+            double time[NB_STAGES] = { 0.0 };
+            check += func(frames, time);
+        }
+        std::vector<double> times[NB_STAGES];
+        for(index_t r=0; r<nb_repeat; ++r) {
+            double time[NB_STAGES] = { 0.0 };
+            check += func(frames, time);
+            for(index_t s=0; s<NB_STAGES; ++s) {
+                times[s].push_back(1000.0 * time[s]);
+            }
+        }
+        for(index_t s=0; s<NB_STAGES; ++s) {
+            if(
+                (s == CLASSIFY && !has_classify) ||
+                (s == CONVEX && !has_convex)
+            ) {
+                continue;
+            }
+            double mean = 0.0;
+            double min = times[s][0];
+            for(double t : times[s]) {
+                mean += t;
+                min = std::min(min, t);
+            }
+            mean /= double(nb_repeat);
+            double var = 0.0;
+            for(double t : times[s]) {
+                var += geo_sqr(t - mean);
+            }
+            var /= double(std::max(nb_repeat, index_t(2)) - 1);
+            char line[256];
+            snprintf(
+                line, sizeof(line),
+                "%-14s %-12s %10.3f %8.3f %10.3f %10.2f",
+                name, stage_names[s], mean, ::sqrt(var), min,
+                1000.0 * mean / double(frames.size())
+            );
+            std::cout << line << std::endl;
+        }
+        std::cout << "(" << name << " check=" << check << ")" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    GEO::initialize();
+
+    if(argc < 2) {
+        std::cerr << "usage: " << argv[0]
+                  << " inputdir [nb_repeat] [nb_warmup]" << std::endl;
+        return 1;
+    }
+    GEO::index_t nb_repeat = (argc > 2) ? GEO::index_t(atoi(argv[2])) : 10;
+    GEO::index_t nb_warmup = (argc > 3) ? GEO::index_t(atoi(argv[3])) : 2;
+    nb_repeat = std::max(nb_repeat, GEO::index_t(1));
+
+    for(int prune=0; prune<2; ++prune) {
+        std::vector<Frame> frames;
+        GEO::index_t nb_points = load_frames(argv[1], frames, prune != 0);
+        if(frames.empty()) {
+            std::cerr << argv[0] << ": no frame in " << argv[1] << std::endl;
+            return 1;
+        }
+        std::cout << (prune ? "pruned: " : "raw: ")
+                  << frames.size() << " frames, " << nb_points << " points, "
+                  << nb_warmup << " warm-up passes, "
+                  << nb_repeat << " passes" << std::endl;
+
+        char line[256];
+        snprintf(
+            line, sizeof(line), "%-14s %-12s %10s %8s %10s %10s",
+            "triangulation", "stage", "mean(ms)", "stddev", "min(ms)",
+            "us/frame"
+        );
+        std::cout << line << std::endl;
+
+        benchmark(
+            "CDT2d", run_CDT2d, frames, nb_warmup, nb_repeat, false, false
+        );
+        benchmark(
+            "ExactCDT2d", run_ExactCDT2d, frames, nb_warmup, nb_repeat,
+            true, false
+        );
+        benchmark(
+            "Triangulation", run_Triangulation, frames, nb_warmup, nb_repeat,
+            true, true
+        );
+    }
+    return 0;
+}
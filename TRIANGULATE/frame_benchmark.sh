@@ -0,0 +1,26 @@
+
+# Benchmark: times the triangulations over the frames of a directory
+#  (before and after removing duplicated and collinear points)
+# usage: frame_benchmark.sh inputdir [nb_repeat] [nb_warmup]
+#  (inputdir contains the frameXXXX.fig files generated by vectorize.sh)
+# License: BSD 3 clauses
+
+if [ $# -lt 1 ]; then
+   echo "usage: $0 inputdir [nb_repeat] [nb_warmup]"
+   exit 1
+fi
+
+INPUTDIR=`realpath $1`
+shift
+cd `dirname $0`
+
+CXXFLAGS="-Wall -Wpedantic -O3 -DNDEBUG -I../"
+OUTDIR=`mktemp -d`
+
+g++ $CXXFLAGS frame_benchmark.cpp encoder.cpp Delaunay_psm.cpp \
+    ../ST_NICCC/io.c -lm \
+    -o $OUTDIR/frame_benchmark || exit 1
+
+$OUTDIR/frame_benchmark $INPUTDIR "$@"
+
+rm -rf $OUTDIR
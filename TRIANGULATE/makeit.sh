@@ -4,5 +4,6 @@
 #CXXFLAGS="-g -Wall -Wpedantic -DCDT_DEBUG -I../"
 CXXFLAGS="-Wall -Wpedantic -O3 -DNDEBUG -I../"
 
-g++ $CXXFLAGS triangulate.cpp Delaunay_psm.cpp ../ST_NICCC/io.c -lm -o triangulate
+g++ $CXXFLAGS triangulate.cpp encoder.cpp Delaunay_psm.cpp ../ST_NICCC/io.c -lm -o triangulate
+g++ $CXXFLAGS vectorize.cpp encoder.cpp Delaunay_psm.cpp ../ST_NICCC/io.c -lm -lpthread -o vectorize
 
@@ -0,0 +1,53 @@
+
+# Rate-distortion benchmark: encodes the frames with several values of
+#  a parameter of triangulate, and compares the decoded frames with
+#  the source frames (see ST_NICCC/rd_ST_NICCC.c)
+# usage: rd_benchmark.sh pathsdir framesdir name value1 [value2 ...]
+#        [-- triangulate options]
+#  (pathsdir and framesdir contain the frameXXXX.fig and frameXXXX.pgm
+#   files generated by vectorize.sh)
+# example: rd_benchmark.sh PATHS FRAMES rate_bytes_per_frame 300 600 1200
+# License: BSD 3 clauses
+
+if [ $# -lt 4 ]; then
+   echo "usage: $0 pathsdir framesdir name value1 [value2 ...] [-- options]"
+   exit 1
+fi
+
+PATHSDIR=`realpath $1`
+FRAMESDIR=`realpath $2`
+NAME=$3
+shift 3
+VALUES=""
+while [ -n "$1" ] && [ "$1" != "--" ]; do
+   VALUES="$VALUES $1"
+   shift
+done
+if [ "$1" = "--" ]; then
+   shift
+fi
+cd `dirname $0`
+
+CXXFLAGS="-Wall -Wpedantic -O3 -DNDEBUG -I../"
+CFLAGS="-Wall -Wpedantic -O3 -DNDEBUG"
+OUTDIR=`mktemp -d`
+
+g++ $CXXFLAGS triangulate.cpp encoder.cpp Delaunay_psm.cpp \
+    ../ST_NICCC/io.c -lm \
+    -o $OUTDIR/triangulate || exit 1
+gcc $CFLAGS -DGFX_BACKEND_MEMORY ../ST_NICCC/rd_ST_NICCC.c \
+    ../ST_NICCC/graphics.c ../ST_NICCC/io.c -lm -o $OUTDIR/rd_ST_NICCC \
+    || exit 1
+
+echo "$NAME: bytes/frame iou psnr min_psnr encoding_ms"
+for VALUE in $VALUES; do
+   START=`date +%s%N`
+   $OUTDIR/triangulate $PATHSDIR $OUTDIR/stream.bin $NAME=$VALUE "$@" \
+       > /dev/null 2>&1
+   END=`date +%s%N`
+   $OUTDIR/rd_ST_NICCC $OUTDIR/stream.bin $FRAMESDIR | \
+       awk -v value=$VALUE -v ms=$(( (END-START)/1000000 )) \
+       '/^#/ { print value ": " $5 " " $7 " " $9 " " $11 " " ms }'
+done
+
+rm -rf $OUTDIR
@@ -0,0 +1,104 @@
+/*
+ * Microbenchmark for the ThreadManagers: measures the overhead of
+ *  parallel_for() with the default ThreadManager (that creates new
+ *  threads for each call) and with the WorkStealingThreadManager
+ *  (persistent pool of threads), for flat and nested parallel loops.
+ */
+
+#include "Delaunay_psm.h"
+#include <chrono>
+#include <iostream>
+#include <cstdlib>
+
+namespace {
+    using namespace GEO;
+
+    /**
+     * \brief A small amount of work, so that the measured time
+     *  is dominated by the overhead of parallel_for().
+     */
+    Numeric::uint64 work(index_t i, index_t grain) {
+        Numeric::uint64 result = i;
+        for(index_t k=0; k<grain; ++k) {
+            result = result * 6364136223846793005ull + 1442695040888963407ull;
+        }
+        return result;
+    }
+
+    /**
+     * \brief Runs the flat and nested benchmarks with the current
+     *  ThreadManager and prints the average time per call.
+     */
+    void benchmark(
+        const char* name, index_t nb_rounds, index_t nb_tasks, index_t grain
+    ) {
+        std::vector<Numeric::uint64> result(nb_tasks*nb_tasks, 0);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for(index_t r=0; r<nb_rounds; ++r) {
+            parallel_for(
+                0, nb_tasks,
+                [&](index_t i) {
+                    result[i] += work(i, grain);
+                }
+            );
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double flat_time = double(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                end-start
+            ).count()
+        ) / double(nb_rounds);
+
+        start = std::chrono::high_resolution_clock::now();
+        for(index_t r=0; r<nb_rounds; ++r) {
+            parallel_for(
+                0, nb_tasks,
+                [&](index_t i) {
+                    parallel_for(
+                        0, nb_tasks,
+                        [&](index_t j) {
+                            result[i*nb_tasks+j] += work(j, grain);
+                        }
+                    );
+                }
+            );
+        }
+        end = std::chrono::high_resolution_clock::now();
+        double nested_time = double(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                end-start
+            ).count()
+        ) / double(nb_rounds);
+
+        Numeric::uint64 check = 0;
+        for(Numeric::uint64 x : result) {
+            check ^= x;
+        }
+
+        std::cout << name << ": "
+                  << "flat: " << flat_time / 1000.0 << " us/call, "
+                  << "nested: " << nested_time / 1000.0 << " us/call "
+                  << "(check=" << check << ")"
+                  << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    GEO::initialize();
+
+    GEO::index_t nb_rounds = (argc > 1) ? GEO::index_t(atoi(argv[1])) : 1000;
+    GEO::index_t grain = (argc > 2) ? GEO::index_t(atoi(argv[2])) : 100;
+    GEO::index_t nb_tasks = GEO::Process::maximum_concurrent_threads();
+
+    benchmark("default", nb_rounds, nb_tasks, grain);
+
+    GEO::WorkStealingThreadManager* pool = new GEO::WorkStealingThreadManager;
+    GEO::Process::set_thread_manager(pool);
+    benchmark("pool   ", nb_rounds, nb_tasks, grain);
+    std::cout << "(" << nb_tasks << " threads, "
+              << pool->nb_steals() << " steals)" << std::endl;
+
+    GEO::Process::terminate();
+    return 0;
+}
@@ -0,0 +1,17 @@
+
+# Microbenchmark: compares the default ThreadManager with the
+#  persistent work-stealing pool
+# usage: thread_benchmark.sh [nb_rounds] [grain]
+# License: BSD 3 clauses
+
+cd `dirname $0`
+
+CXXFLAGS="-Wall -Wpedantic -O3 -DNDEBUG -I../"
+OUTDIR=`mktemp -d`
+
+g++ $CXXFLAGS thread_benchmark.cpp Delaunay_psm.cpp -lm -lpthread \
+    -o $OUTDIR/thread_benchmark || exit 1
+
+$OUTDIR/thread_benchmark "$@"
+
+rm -rf $OUTDIR
@@ -0,0 +1,756 @@
+/*
+ * Vectorizer driver: converts a black and white video into a ST_NICCC
+ *  stream, like vectorize.sh followed by triangulate, with the stages
+ *  running concurrently:
+ *   decode:      ffmpeg extracts the frames (one process for the video)
+ *   threshold:   the frames are saved in FRAMES/ and converted into
+ *                bitmaps
+ *   trace:       potrace converts the bitmaps into PATHS/frameXXXX.fig
+ *                (a pool of workers, one process per frame)
+ *   triangulate: the .fig files are triangulated and encoded in frame
+ *                order, see fig_2_ST_NICCC()
+ *  The stages are connected by bounded queues, so that a slow stage
+ *  does not let the frames pile up in memory.
+ *  The outputs of decode and trace are cached (see StageCache), so that
+ *  running again with other triangulate options only triangulates.
+ * usage: vectorize [-fps n] [-r n] [-nc n] [-O tolerance] [-i video]
+ *                  [triangulate options] [outputfile]
+ */
+
+#include "encoder.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <sys/stat.h>
+
+namespace {
+    using namespace GEO;
+
+    /**
+     * \brief A queue with a maximum size, shared by threads
+     * \details push() waits while the queue is full, pop() waits while
+     *  the queue is empty and not closed.
+     */
+    template <class T> class BoundedQueue {
+    public:
+
+        /**
+         * \brief BoundedQueue constructor
+         * \param[in] max_size the maximum number of items
+         */
+        BoundedQueue(index_t max_size) :
+            max_size_(std::max(max_size, index_t(1))),
+            nb_producers_(1) {
+        }
+
+        /**
+         * \brief Sets the number of threads that push items
+         * \details The queue is closed when all of them called close().
+         */
+        void set_nb_producers(index_t nb) {
+            nb_producers_ = nb;
+        }
+
+        /**
+         * \brief Adds an item, waits while the queue is full
+         */
+        void push(T item) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_full_.wait(lock, [this]{ return items_.size() < max_size_; });
+            items_.push_back(std::move(item));
+            not_empty_.notify_one();
+        }
+
+        /**
+         * \brief Gets the next item, waits while the queue is empty
+         * \retval true if an item was retrieved
+         * \retval false if the queue is empty and closed
+         */
+        bool pop(T& item) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(
+                lock, [this]{ return !items_.empty() || nb_producers_ == 0; }
+            );
+            if(items_.empty()) {
+                return false;
+            }
+            item = std::move(items_.front());
+            items_.pop_front();
+            not_full_.notify_one();
+            return true;
+        }
+
+        /**
+         * \brief Indicates that a producer will not push more items
+         */
+        void close() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            --nb_producers_;
+            not_empty_.notify_all();
+        }
+
+    private:
+        index_t max_size_;
+        index_t nb_producers_;
+        std::deque<T> items_;
+        std::mutex mutex_;
+        std::condition_variable not_full_;
+        std::condition_variable not_empty_;
+    };
+
+    /**
+     * \brief A frame of the video, in the queues between the stages
+     */
+    struct VideoFrame {
+        int id;
+        int width;
+        int height;
+        std::vector<uint8_t> pixels; // grayscale image, then bitmap
+        bool ok;
+    };
+
+    enum Stage {
+        DECODE, THRESHOLD, TRACE, TRIANGULATE, NB_STAGES
+    };
+
+    const char* stage_names[NB_STAGES] = {
+        "decode", "threshold", "trace", "triangulate"
+    };
+
+    /**
+     * \brief Time spent working (not waiting on the queues) and number
+     *  of frames of each stage, summed over the threads of the stage
+     */
+    struct StageStats {
+        std::mutex mutex;
+        double busy_ms[NB_STAGES] = { 0.0, 0.0, 0.0, 0.0 };
+        index_t nb_frames[NB_STAGES] = { 0, 0, 0, 0 };
+
+        void add(
+            Stage stage, std::chrono::steady_clock::time_point start
+        ) {
+            double ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start
+            ).count();
+            std::unique_lock<std::mutex> lock(mutex);
+            busy_ms[stage] += ms;
+            ++nb_frames[stage];
+        }
+    };
+
+    /**
+     * \brief Options of vectorize.sh
+     */
+    struct Options {
+        std::string fps = "12";
+        std::string resolution = "128";
+        std::string nb_colors = "2";
+        std::string tolerance = "20.0";
+        std::string input = "VIDEO/video.mp4";
+        bool no_cache = false;
+    };
+
+    /**
+     * \brief Content-addressed cache of the outputs of the stages
+     * \details An output is stored in a file named after a hash of the
+     *  input of the stage and of its parameters, so that it is found
+     *  again whatever the frame number and the other parameters. Files
+     *  are written under a temporary name and renamed, so that workers
+     *  never see incomplete files.
+     */
+    class StageCache {
+    public:
+
+        /**
+         * \brief StageCache constructor
+         * \param[in] dir the cache directory, or "" to disable the cache
+         */
+        StageCache(const std::string& dir) :
+            dir_(dir), nb_lookups_(0), nb_hits_(0) {
+            if(dir_ != "") {
+                mkdir(dir_.c_str(), 0755);
+            }
+        }
+
+        /**
+         * \brief Tests whether the cache is used
+         */
+        bool enabled() const {
+            return dir_ != "";
+        }
+
+        /**
+         * \brief Computes the key of an input
+         * \param[in] data , size the bytes of the input
+         * \param[in] params the parameters of the stage
+         */
+        static std::string key(
+            const uint8_t* data, size_t size, const std::string& params
+        ) {
+            Numeric::uint64 h = hash(
+                reinterpret_cast<const uint8_t*>(params.data()),
+                params.size(), 1469598103934665603ull // FNV-1a
+            );
+            h = hash(data, size, h);
+            char result[17];
+            snprintf(result, sizeof(result), "%016llx", (unsigned long long)h);
+            return std::string(result);
+        }
+
+        /**
+         * \brief Computes the key of a file
+         * \return the key, or "" if the file cannot be read
+         */
+        static std::string file_key(
+            const std::string& filename, const std::string& params
+        ) {
+            FILE* f = fopen(filename.c_str(), "rb");
+            if(f == nullptr) {
+                return "";
+            }
+            std::vector<uint8_t> buffer(1 << 20);
+            Numeric::uint64 h = 1469598103934665603ull;
+            for(;;) {
+                size_t nb = fread(buffer.data(), 1, buffer.size(), f);
+                if(nb == 0) {
+                    break;
+                }
+                h = hash(buffer.data(), nb, h);
+            }
+            fclose(f);
+            return key(
+                reinterpret_cast<const uint8_t*>(&h), sizeof(h), params
+            );
+        }
+
+        /**
+         * \brief Gets the name of the cached file of a key
+         */
+        std::string path(const std::string& key, const std::string& ext) {
+            return dir_ + "/" + key + ext;
+        }
+
+        /**
+         * \brief Copies a cached output
+         * \param[in] key the key of the input
+         * \param[in] ext the extension of the cached file
+         * \param[in] filename where to copy the cached file
+         * \retval true if the output was in the cache
+         * \retval false otherwise
+         */
+        bool fetch(
+            const std::string& key, const std::string& ext,
+            const std::string& filename
+        ) {
+            if(!enabled()) {
+                return false;
+            }
+            ++nb_lookups_;
+            if(!copy(path(key,ext), filename)) {
+                return false;
+            }
+            ++nb_hits_;
+            return true;
+        }
+
+        /**
+         * \brief Stores an output in the cache
+         * \param[in] key the key of the input
+         * \param[in] ext the extension of the cached file
+         * \param[in] filename the output
+         */
+        void store(
+            const std::string& key, const std::string& ext,
+            const std::string& filename
+        ) {
+            if(!enabled()) {
+                return;
+            }
+            std::string tmp = path(key, ext + ".tmp");
+            if(copy(filename, tmp)) {
+                rename(tmp.c_str(), path(key,ext).c_str());
+            } else {
+                remove(tmp.c_str());
+            }
+        }
+
+        index_t nb_lookups() const {
+            return nb_lookups_;
+        }
+
+        index_t nb_hits() const {
+            return nb_hits_;
+        }
+
+    protected:
+        static Numeric::uint64 hash(
+            const uint8_t* data, size_t size, Numeric::uint64 h
+        ) {
+            for(size_t i=0; i<size; ++i) {
+                h ^= Numeric::uint64(data[i]);
+                h *= 1099511628211ull;
+            }
+            return h;
+        }
+
+        static bool copy(const std::string& from, const std::string& to) {
+            std::ifstream in(from, std::ios::binary);
+            if(!in) {
+                return false;
+            }
+            std::ofstream out(to, std::ios::binary);
+            // operator<< sets failbit if nothing could be copied
+            // (empty or unreadable input)
+            if(!(out << in.rdbuf())) {
+                return false;
+            }
+            out.close();
+            return bool(out);
+        }
+
+    private:
+        std::string dir_;
+        std::atomic<index_t> nb_lookups_;
+        std::atomic<index_t> nb_hits_;
+    };
+
+    /**
+     * \brief Reads a binary PGM image from a stream
+     * \retval true if an image was read
+     * \retval false at the end of the stream or on error
+     */
+    bool read_pgm(FILE* in, VideoFrame& frame) {
+        int maxval = 0;
+        if(
+            fscanf(
+                in, "P5 %d %d %d", &frame.width, &frame.height, &maxval
+            ) != 3 ||
+            maxval > 255 || frame.width <= 0 || frame.height <= 0
+        ) {
+            return false;
+        }
+        fgetc(in); // single whitespace before the pixels
+        frame.pixels.resize(size_t(frame.width) * size_t(frame.height));
+        return fread(
+            frame.pixels.data(), 1, frame.pixels.size(), in
+        ) == frame.pixels.size();
+    }
+
+    /**
+     * \brief Saves the grayscale image of a frame
+     * \retval true if the image was saved
+     * \retval false on error
+     */
+    bool save_pgm(const VideoFrame& frame, const std::string& filename) {
+        FILE* out = fopen(filename.c_str(), "wb");
+        if(out == nullptr) {
+            std::cerr << "Could not save " << filename << std::endl;
+            return false;
+        }
+        bool ok =
+            fprintf(out, "P5\n%d %d\n255\n", frame.width, frame.height) > 0
+            && fwrite(
+                frame.pixels.data(), 1, frame.pixels.size(), out
+            ) == frame.pixels.size();
+        ok = (fclose(out) == 0) && ok;
+        if(!ok) {
+            std::cerr << "Could not save " << filename << std::endl;
+        }
+        return ok;
+    }
+
+    /**
+     * \brief Converts the grayscale image of a frame into a PBM bitmap
+     * \details Pixels darker than half intensity are black, as with the
+     *  default threshold of potrace.
+     */
+    void threshold(VideoFrame& frame) {
+        std::ostringstream header;
+        header << "P4\n" << frame.width << " " << frame.height << "\n";
+        std::string H = header.str();
+        int row_bytes = (frame.width + 7) / 8;
+        std::vector<uint8_t> bitmap(H.begin(), H.end());
+        size_t offset = bitmap.size();
+        bitmap.resize(offset + size_t(row_bytes) * size_t(frame.height), 0);
+        for(int y=0; y<frame.height; ++y) {
+            const uint8_t* row = &frame.pixels[size_t(y)*size_t(frame.width)];
+            for(int x=0; x<frame.width; ++x) {
+                if(row[x] < 128) {
+                    bitmap[offset + size_t(y*row_bytes + x/8)] |=
+                        uint8_t(0x80 >> (x & 7));
+                }
+            }
+        }
+        frame.pixels.swap(bitmap);
+    }
+
+    /**
+     * \brief Traces the bitmap of a frame into PATHS/frameXXXX.fig
+     * \details The .fig file is taken from the cache if the same bitmap
+     *  was traced with the same options.
+     * \return true on success
+     */
+    bool trace(
+        const VideoFrame& frame, const Options& options, StageCache& cache
+    ) {
+        std::string params =
+            "potrace -b xfig -a 0 -O " + options.tolerance +
+            " -r " + options.resolution + "x" + options.resolution;
+        std::string filename = "PATHS/frame" + to_string(frame.id,4) + ".fig";
+        std::string key = StageCache::key(
+            frame.pixels.data(), frame.pixels.size(), params
+        );
+        if(cache.fetch(key, ".fig", filename)) {
+            return true;
+        }
+        std::string command = params + " -o " + filename;
+        FILE* potrace = popen(command.c_str(), "w");
+        if(potrace == nullptr) {
+            return false;
+        }
+        bool ok = fwrite(
+            frame.pixels.data(), 1, frame.pixels.size(), potrace
+        ) == frame.pixels.size();
+        ok = (pclose(potrace) == 0) && ok;
+        if(ok) {
+            cache.store(key, ".fig", filename);
+        }
+        return ok;
+    }
+
+    /**
+     * \brief Parses a numeric option
+     * \details The value is re-formatted, so that only a number is
+     *  passed to the shell in the potrace and ffmpeg commands.
+     * \param[in] value the value given on the command line
+     * \param[in] integer whether the value should be an integer
+     * \param[out] result the re-formatted value
+     * \retval true if \p value is a positive or zero number
+     * \retval false otherwise, \p result is left unchanged
+     */
+    bool parse_number(
+        const std::string& value, bool integer, std::string& result
+    ) {
+        const char* begin = value.c_str();
+        char* end = nullptr;
+        double x = integer ? double(strtol(begin, &end, 10)) :
+                             strtod(begin, &end);
+        if(end == begin || *end != '\0' || !(x >= 0.0 && x < 1e9)) {
+            return false;
+        }
+        std::ostringstream out;
+        out << std::setprecision(10) << x;
+        result = out.str();
+        return true;
+    }
+
+    /**
+     * \brief Quotes a string for the shell
+     * \details The string is enclosed in single quotes, in which the
+     *  shell does not expand anything. Its single quotes are replaced
+     *  with '\'' (close the quotes, escaped quote, reopen).
+     */
+    std::string shell_quote(const std::string& s) {
+        std::string result = "'";
+        for(char c: s) {
+            if(c == '\'') {
+                result += "'\\''";
+            } else {
+                result += c;
+            }
+        }
+        result += "'";
+        return result;
+    }
+
+    void print_help(const char* program) {
+        std::cerr
+            << "usage: " << program
+            << " [options] [triangulate options] [outputfile]" << std::endl
+            << "  -fps nnn          frames per second. Default=12" << std::endl
+            << "  -r,-resolution nnn internal resolution for vectorizing."
+            << " Default=128" << std::endl
+            << "  -nc,-nb_colors nnn number of colors. Default=2"
+            << " (black and white, the only mode supported)" << std::endl
+            << "  -O,-tolerance t   potrace tolerance. Default=20.0"
+            << std::endl
+            << "  -i,-input video   input video. Default=VIDEO/video.mp4"
+            << std::endl
+            << "  -no_cache         recompute the decoded and traced frames"
+            << std::endl
+            << "  threads=n         trace workers (0: one per core)"
+            << std::endl
+            << "  queue_size=n      frames between two stages. Default=8"
+            << std::endl
+            << "  cache=dir         cache of the decoded and traced frames."
+            << " Default=CACHE" << std::endl
+            << "  (run triangulate -h for the triangulate options)"
+            << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    GEO::initialize();
+    GEO::CmdLine::import_arg_group("standard");
+    GEO::CmdLine::import_arg_group("algo");
+    declare_encoder_args();
+
+    GEO::CmdLine::declare_arg(
+        "threads",0,"number of trace workers or 0 (one per core)"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "queue_size",8,"maximum number of frames between two stages"
+    );
+
+    GEO::CmdLine::declare_arg(
+        "cache","CACHE",
+        "directory of the cached outputs of the stages"
+    );
+
+    // Options of vectorize.sh, the other ones are passed to CmdLine
+    Options options;
+    std::vector<char*> args(1, argv[0]);
+    for(int i=1; i<argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = (i+1 < argc);
+        bool valid = true;
+        if(arg == "-h" || arg == "-help" || arg == "--help") {
+            print_help(argv[0]);
+            return 0;
+        } else if(arg == "-fps" && has_value) {
+            valid = parse_number(argv[++i], false, options.fps);
+        } else if((arg == "-r" || arg == "-resolution") && has_value) {
+            valid = parse_number(argv[++i], true, options.resolution);
+        } else if((arg == "-nc" || arg == "-nb_colors") && has_value) {
+            valid = parse_number(argv[++i], true, options.nb_colors);
+        } else if((arg == "-O" || arg == "-tolerance") && has_value) {
+            valid = parse_number(argv[++i], false, options.tolerance);
+        } else if((arg == "-i" || arg == "-input") && has_value) {
+            options.input = argv[++i];
+        } else if(arg == "-no_cache") {
+            options.no_cache = true;
+        } else {
+            args.push_back(argv[i]);
+        }
+        if(!valid) {
+            std::cerr << argv[0] << ": invalid value for " << arg << ": "
+                      << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    if(atoi(options.nb_colors.c_str()) >= 3) {
+        std::cerr << argv[0] << ": only black and white videos are "
+                  << "supported, use vectorize.sh for colors" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> filenames;
+    if(
+        !GEO::CmdLine::parse(
+            int(args.size()), args.data(), filenames, "<outputfile>"
+        )
+    ) {
+        return 1;
+    }
+    std::string output_filename = "stream.bin";
+    if(filenames.size() >= 1) {
+        output_filename = filenames[0];
+    }
+
+    index_t nb_workers = index_t(GEO::CmdLine::get_arg_int("threads"));
+    if(nb_workers == 0) {
+        nb_workers = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    index_t queue_size = index_t(GEO::CmdLine::get_arg_int("queue_size"));
+
+    mkdir("FRAMES", 0755);
+    mkdir("PATHS", 0755);
+
+    ST_NICCC_IO io;
+    if(!st_niccc_open(&io,output_filename.c_str(),ST_NICCC_WRITE)) {
+        std::cerr << "Could not create " << output_filename << std::endl;
+        return 1;
+    }
+
+    // Decoded frames are cached as a whole, under the key of the video
+    // and of the ffmpeg options. If they are not in the cache, ffmpeg
+    // writes them in a pipe, and a copy is saved in the cache.
+    StageCache cache(
+        options.no_cache ? std::string() : GEO::CmdLine::get_arg("cache")
+    );
+    std::string filters =
+        "fps=" + options.fps + ",scale=" + options.resolution +
+        ":-2,setsar=1:1";
+    std::string decode_key = cache.enabled() ?
+        StageCache::file_key(options.input, filters) : std::string();
+    std::string decoded_dir = cache.path(decode_key, ".frames");
+    std::string decoded_tmp = decoded_dir + ".tmp";
+    bool decode_hit = false;
+    FILE* ffmpeg = nullptr;
+    if(decode_key != "") {
+        // The directory is renamed once all the frames are decoded
+        struct stat st;
+        decode_hit =
+            (stat(decoded_dir.c_str(), &st) == 0) && S_ISDIR(st.st_mode);
+        if(!decode_hit) {
+            mkdir(decoded_tmp.c_str(), 0755);
+        }
+    }
+    if(!decode_hit) {
+        std::string command =
+            "ffmpeg -loglevel error -i " + shell_quote(options.input) +
+            " -vf " + filters + " -f image2pipe -vcodec pgm -";
+        ffmpeg = popen(command.c_str(), "r");
+        if(ffmpeg == nullptr) {
+            std::cerr << "Could not run ffmpeg" << std::endl;
+            return 1;
+        }
+    }
+    std::atomic<index_t> nb_decode_lookups(0);
+    std::atomic<index_t> nb_decode_hits(0);
+
+    StageStats stats;
+    BoundedQueue<VideoFrame> decoded(queue_size);
+    BoundedQueue<VideoFrame> thresholded(queue_size);
+    BoundedQueue<VideoFrame> traced(queue_size);
+    traced.set_nb_producers(nb_workers);
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread decoder([&]() {
+        // The decoded frames are only cached if ffmpeg succeeded and
+        // all of them were saved
+        bool complete = false;
+        bool saved = true;
+        for(int id=1; ; ++id) {
+            auto t = std::chrono::steady_clock::now();
+            VideoFrame frame;
+            frame.id = id;
+            frame.ok = true;
+            std::string cached =
+                "/frame" + to_string(id,4) + ".pgm";
+            if(decode_hit) {
+                FILE* f = fopen((decoded_dir + cached).c_str(), "rb");
+                bool ok = (f != nullptr) && read_pgm(f, frame);
+                if(f != nullptr) {
+                    fclose(f);
+                }
+                if(!ok) {
+                    break;
+                }
+            } else if(!read_pgm(ffmpeg, frame)) {
+                complete = (pclose(ffmpeg) == 0);
+                break;
+            } else if(decode_key != "" && saved) {
+                saved = save_pgm(frame, decoded_tmp + cached);
+            }
+            ++nb_decode_lookups;
+            nb_decode_hits += index_t(decode_hit);
+            stats.add(DECODE, t);
+            decoded.push(std::move(frame));
+        }
+        if(complete && saved && decode_key != "") {
+            rename(decoded_tmp.c_str(), decoded_dir.c_str());
+        }
+        decoded.close();
+    });
+
+    std::thread thresholder([&]() {
+        VideoFrame frame;
+        while(decoded.pop(frame)) {
+            auto t = std::chrono::steady_clock::now();
+            save_pgm(frame, "FRAMES/frame" + to_string(frame.id,4) + ".pgm");
+            threshold(frame);
+            stats.add(THRESHOLD, t);
+            thresholded.push(std::move(frame));
+        }
+        thresholded.close();
+    });
+
+    std::vector<std::thread> tracers;
+    for(index_t w=0; w<nb_workers; ++w) {
+        tracers.emplace_back([&]() {
+            VideoFrame frame;
+            while(thresholded.pop(frame)) {
+                auto t = std::chrono::steady_clock::now();
+                frame.ok = trace(frame, options, cache);
+                frame.pixels.clear();
+                stats.add(TRACE, t);
+                traced.push(std::move(frame));
+            }
+            traced.close();
+        });
+    }
+
+    // Triangulation and encoding, in frame order (the encoder keeps
+    // the previous frames for incremental updates, hold frames and
+    // rate control).
+    begin_stream(&io);
+    std::map<int, bool> ready;
+    int next_id = 1;
+    bool failed = false;
+    VideoFrame frame;
+    while(traced.pop(frame)) {
+        ready[frame.id] = frame.ok;
+        while(!failed && ready.count(next_id) != 0) {
+            auto t = std::chrono::steady_clock::now();
+            std::string filename =
+                "PATHS/frame" + to_string(next_id,4) + ".fig";
+            if(!ready[next_id] || !fig_2_ST_NICCC(filename, &io)) {
+                std::cerr << "Could not trace " << filename
+                          << ", stopping the stream there" << std::endl;
+                failed = true;
+                break;
+            }
+            stats.add(TRIANGULATE, t);
+            ready.erase(next_id);
+            ++next_id;
+        }
+    }
+    end_stream(&io);
+    st_niccc_close(&io);
+
+    decoder.join();
+    thresholder.join();
+    for(std::thread& tracer: tracers) {
+        tracer.join();
+    }
+
+    double total_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+    std::cerr << "Stages (" << nb_workers << " trace workers):" << std::endl;
+    for(index_t s=0; s<NB_STAGES; ++s) {
+        double busy = stats.busy_ms[s];
+        std::cerr << "  " << stage_names[s] << ": "
+                  << stats.nb_frames[s] << " frames, "
+                  << busy << " ms busy, "
+                  << (busy > 0.0 ? 1000.0 * double(stats.nb_frames[s]) / busy
+                                 : 0.0)
+                  << " frames/s" << std::endl;
+    }
+    if(cache.enabled()) {
+        std::cerr << "  cache hits: decode: " << nb_decode_hits
+                  << "/" << nb_decode_lookups
+                  << " frames, trace: " << cache.nb_hits() << "/"
+                  << cache.nb_lookups() << " frames" << std::endl;
+    }
+    std::cerr << "  total: " << next_id-1 << " frames in " << total_ms
+              << " ms, "
+              << (total_ms > 0.0 ? 1000.0 * double(next_id-1) / total_ms : 0.0)
+              << " frames/s" << std::endl;
+
+    if(GEO::CmdLine::get_arg_bool("timings")) {
+        GEO::StageProfiler::instance().print_summary(
+            std::cerr, GEO::index_t(GEO::CmdLine::get_arg_int("timings_top"))
+        );
+    }
+    return failed ? 1 : 0;
+}
@@ -1,6 +1,7 @@
 
 # Vectorizer: converts a black and white video into triangulations (WIP)
 # Bruno Levy, April 2023
+# (TRIANGULATE/vectorize runs the same steps and triangulate concurrently)
 # License: BSD 3 clauses
 
 VIDEOSOURCE=https://ia802905.us.archive.org/19/items/TouhouBadApple/Touhou%20-%20Bad%20Apple.mp4
@@ -12,6 +13,7 @@ FPS=12
 RESOLUTION=128
 TOLERANCE=20.0
 NB_COLORS=2
+CACHE=CACHE
 
 ####################################################################
 
@@ -84,12 +86,49 @@ fig2movetolineto() {
 
 ####################################################################
 
+# The extracted frames and the traced paths are stored in CACHE, in
+# files named after the md5 of their input and of the options, so that
+# running again with other options only recomputes what changed.
+
+NB_CACHE_LOOKUPS=0
+NB_CACHE_HITS=0
+
+# cache_key file options
+# prints the key of a file processed with the given options
+cache_key() {
+   (cat $1; echo "$2") | md5sum | cut -d' ' -f1
+}
+
+# cached_potrace input.pnm output.fig
+# runs potrace, or copies its output from the cache
+cached_potrace() {
+   OPTIONS="-b xfig -a 0 -O $TOLERANCE -r $RESOLUTION"x"$RESOLUTION"
+   if [ -z "$CACHE" ]; then
+      potrace $OPTIONS $1 -o $2
+      return
+   fi
+   NB_CACHE_LOOKUPS=$((NB_CACHE_LOOKUPS+1))
+   KEY=`cache_key $1 "potrace $OPTIONS"`
+   if [ -f $CACHE/$KEY.fig ]; then
+      NB_CACHE_HITS=$((NB_CACHE_HITS+1))
+      cp $CACHE/$KEY.fig $2
+   else
+      # copied under a temporary name, then renamed (atomic), so that
+      # concurrent jobs never see an incomplete file
+      potrace $OPTIONS $1 -o $2 &&
+         cp $2 $CACHE/$KEY.fig.tmp.$$ &&
+         mv $CACHE/$KEY.fig.tmp.$$ $CACHE/$KEY.fig
+   fi
+}
+
+####################################################################
+
 vectorize_BW() {
    BASENAME=`basename $1 .pgm`
    FIGFRAME=PATHS/$BASENAME.fig
    OBJFRAME=PATHS/$BASENAME.obj
    VECTORFRAME=PATHS/$BASENAME.vec
-   potrace -b xfig -a 0 -O $TOLERANCE -r $RESOLUTION"x"$RESOLUTION $1 -o $FIGFRAME
+   cached_potrace $1 $FIGFRAME
    fig2obj $FIGFRAME $OBJFRAME
    fig2movetolineto $FIGFRAME $VECTORFRAME
 }
@@ -130,7 +169,7 @@ vectorize_color() {
         eval $cmd
         cmd="convert "$BASEFRAME"_"$i"_isolated.png -fill \"#FFFFFF\" -opaque \"#FFFFFF\" -fill \"#000000\" -opaque \"#000001\" "$BASEFRAME"_"$i"_layer.ppm"
         eval $cmd
-        potrace -b xfig -a 0 -O $TOLERANCE -r $RESOLUTION"x"$RESOLUTION $BASEFRAME"_"$i"_layer.ppm" -o PATHS/$BASENAME"_"$i"_layer".fig
+        cached_potrace $BASEFRAME"_"$i"_layer.ppm" PATHS/$BASENAME"_"$i"_layer".fig
         fig2obj PATHS/$BASENAME"_"$i"_layer".fig PATHS/$BASENAME"_"$i"_layer".obj
     done
 }
@@ -164,6 +203,10 @@ while [ -n "$1" ]; do
             INPUT_VIDEOFILE=$1
             shift
             ;;
+        -no_cache)
+            shift
+            CACHE=
+            ;;
         -h | -help | --help)
             cat <<EOF
 NAME
@@ -194,6 +237,10 @@ OPTIONS
 	Default is 20.0. potrace's default is 0.2
 
     -i,-input videofile.mp4        
+
+    -no_cache
+        Recomputes the frames and paths instead of taking them
+        from CACHE/
 EOF
             exit
             ;;
@@ -206,7 +253,7 @@ done
 
 ####################################################################
 
-mkdir -p VIDEO FRAMES PATHS
+mkdir -p VIDEO FRAMES PATHS $CACHE
 
 # Download video
 #echo "$0: [step 0] downloading video..."
@@ -220,9 +267,24 @@ mkdir -p VIDEO FRAMES PATHS
 echo "$0: [step 1] extracting frames..."
 rm -f FRAMES/*
 if [[ "$NB_COLORS" -lt 3 ]]; then
-   ffmpeg -i $INPUT_VIDEOFILE -vf fps=$FPS,scale=$RESOLUTION:-2,setsar=1:1 FRAMES/frame%04d.pgm
+   FRAME_FORMAT=pgm
 else
-   ffmpeg -i $INPUT_VIDEOFILE -vf fps=$FPS,scale=$RESOLUTION:-2,setsar=1:1 FRAMES/frame%04d.ppm
+   FRAME_FORMAT=ppm
+fi
+FILTERS=fps=$FPS,scale=$RESOLUTION:-2,setsar=1:1
+if [ -n "$CACHE" ]; then
+   KEY=`cache_key $INPUT_VIDEOFILE "ffmpeg $FILTERS $FRAME_FORMAT"`
+fi
+if [ -n "$CACHE" ] && [ -d $CACHE/$KEY.frames ]; then
+   echo "   Using cached frames $CACHE/$KEY.frames"
+   cp $CACHE/$KEY.frames/* FRAMES/
+else
+   ffmpeg -i $INPUT_VIDEOFILE -vf $FILTERS FRAMES/frame%04d.$FRAME_FORMAT &&
+   if [ -n "$CACHE" ]; then
+      rm -rf $CACHE/$KEY.frames.tmp
+      cp -r FRAMES $CACHE/$KEY.frames.tmp &&
+      mv $CACHE/$KEY.frames.tmp $CACHE/$KEY.frames
+   fi
 fi
 
 # Step 2: trace frames
@@ -240,3 +302,6 @@ else
     done
 fi
 
+if [ -n "$CACHE" ]; then
+   echo "$0: cache hits: $NB_CACHE_HITS/$NB_CACHE_LOOKUPS traced frames"
+fi